@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    EnvelopeImporter.cpp
+    Created: 18 Oct 2026 6:02:44pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "EnvelopeImporter.h"
+
+EnvelopeImporter::EnvelopeImporter() : juce::Thread("Envelope Importer") {
+    formatManager.registerBasicFormats();
+}
+
+EnvelopeImporter::~EnvelopeImporter() {
+    stopThread(2000);
+}
+
+void EnvelopeImporter::start(const juce::File& fileToImport, double cycleLengthSeconds, Callback callback) {
+    ///start a new import, a running one is cancelled first
+    cancel();
+    runGeneration = latestGeneration->load();
+    file = fileToImport;
+    cycleSeconds = cycleLengthSeconds;
+    onFinished = std::move(callback);
+    progress = 0.0f;
+    startThread(juce::Thread::Priority::low);
+}
+
+void EnvelopeImporter::cancel() {
+    ///also drops a result that is already on its way to the message thread
+    ++*latestGeneration;
+    stopThread(2000);
+}
+
+bool EnvelopeImporter::isImporting() const {
+    return isThreadRunning();
+}
+
+float EnvelopeImporter::getProgress() const {
+    return progress.load();
+}
+
+void EnvelopeImporter::run() {
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0) {
+        finish({});
+        return;
+    }
+    
+    const juce::int64 length = reader->lengthInSamples;
+    const int numChannels = (int) reader->numChannels;
+    
+    //files shorter than one cycle are treated as exactly one cycle
+    juce::int64 cycleSamples = (juce::int64) (cycleSeconds * reader->sampleRate);
+    if (cycleSamples <= 0 || cycleSamples > length)
+        cycleSamples = length;
+    
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    std::vector<double> sums(numBins, 0.0);
+    std::vector<juce::int64> counts(numBins, 0);
+    
+    for (juce::int64 position = 0; position < length; position += blockSize) {
+        if (threadShouldExit())
+            return;
+        
+        const int numSamples = (int) juce::jmin((juce::int64) blockSize, length - position);
+        reader->read(&buffer, 0, numSamples, position, true, true);
+        
+        //mean square over all channels, accumulated into the bin of its position inside the cycle
+        for (int i = 0; i < numSamples; ++i) {
+            float squared = 0.0f;
+            for (int channel = 0; channel < numChannels; ++channel) {
+                float sample = buffer.getSample(channel, i);
+                squared += sample * sample;
+            }
+            const juce::int64 cyclePosition = (position + i) % cycleSamples;
+            const int bin = (int) (cyclePosition * numBins / cycleSamples);
+            sums[bin] += squared / numChannels;
+            ++counts[bin];
+        }
+        
+        progress = (float) (position + numSamples) / (float) length;
+    }
+    
+    std::vector<float> envelope(numBins, 0.0f);
+    float peak = 0.0f;
+    for (int bin = 0; bin < numBins; ++bin) {
+        if (counts[bin] > 0)
+            envelope[bin] = (float) std::sqrt(sums[bin] / counts[bin]);
+        peak = juce::jmax(peak, envelope[bin]);
+    }
+    
+    //normalize so the loudest part of the cycle reaches the top of the shape
+    if (peak > 0.0f) {
+        for (auto& value : envelope)
+            value /= peak;
+    }
+    
+    finish(std::move(envelope));
+}
+
+void EnvelopeImporter::finish(std::vector<float> envelope) {
+    progress = 1.0f;
+    juce::MessageManager::callAsync([callback = onFinished, envelope = std::move(envelope),
+                                     latest = latestGeneration, generation = runGeneration]() mutable {
+        if (callback && latest->load() == generation)
+            callback(std::move(envelope));
+    });
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    EnvelopeImporter.h
+    Created: 18 Oct 2026 6:02:44pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_audio_formats/juce_audio_formats.h>
+
+
+///extracts the amplitude envelope of an audio file on a background thread
+///the file is streamed block by block and folded onto one cycle, so every cycle of
+///the file contributes to the same bins and long stems never have to fit into memory
+///only the latest import calls back, a result that arrives after a newer start or a cancel is dropped
+class EnvelopeImporter : private juce::Thread {
+    
+public:
+    
+    using Callback = std::function<void(std::vector<float> envelope)>;
+    
+    static constexpr int numBins = 256;
+    
+    EnvelopeImporter();
+    ~EnvelopeImporter() override;
+    
+    void start(const juce::File& file, double cycleSeconds, Callback onFinished);
+    void cancel();
+    bool isImporting() const;
+    float getProgress() const;
+    
+private:
+    
+    static constexpr int blockSize = 8192;
+    
+    juce::AudioFormatManager formatManager;
+    juce::File file;
+    double cycleSeconds = 0.0;
+    Callback onFinished;
+    std::atomic<float> progress { 0.0f };
+    
+    //bumped by every start and cancel, shared with the posted callbacks so they can check it after the importer is gone
+    std::shared_ptr<std::atomic<juce::uint32>> latestGeneration = std::make_shared<std::atomic<juce::uint32>>(0);
+    juce::uint32 runGeneration = 0;
+    
+    void run() override;
+    void finish(std::vector<float> envelope);
+};
@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    FreehandStroke.cpp
+    Created: 18 Oct 2026 4:31:18pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "FreehandStroke.h"
+
+void FreehandStroke::begin(juce::Point<float> point) {
+    clear();
+    active = true;
+    points.push_back(point);
+    anchors.push_back(0);
+}
+
+void FreehandStroke::addPoint(juce::Point<float> point) {
+    ///the shape is a function of x, so points that don't move right are dropped
+    if (!active || point.getX() <= points.back().getX())
+        return;
+    
+    points.push_back(point);
+    simplifyTail();
+}
+
+void FreehandStroke::finish() {
+    active = false;
+    rebuildSegments();
+}
+
+void FreehandStroke::clear() {
+    points.clear();
+    anchors.clear();
+    segments.clear();
+    active = false;
+}
+
+bool FreehandStroke::isActive() const {
+    return active;
+}
+
+void FreehandStroke::setTolerance(float newTolerance) {
+    tolerance = newTolerance;
+}
+
+void FreehandStroke::setControlRange(juce::Range<float> newControlRange) {
+    controlRange = newControlRange;
+}
+
+const std::vector<FreehandStroke::Segment>& FreehandStroke::getSegments() const {
+    return segments;
+}
+
+juce::Path FreehandStroke::createPreviewPath() const {
+    ///committed segments as curves, the part that is still open as the raw points
+    juce::Path path;
+    if (points.empty())
+        return path;
+    
+    path.startNewSubPath(points.front());
+    for (size_t i = 1; i < anchors.size(); ++i) {
+        float controlY;
+        fitQuadratic(points, anchors[i - 1], anchors[i], controlRange, controlY);
+        auto start = points[anchors[i - 1]];
+        auto end = points[anchors[i]];
+        path.quadraticTo((start.getX() + end.getX()) * 0.5f, controlY, end.getX(), end.getY());
+    }
+    for (size_t i = anchors.back() + 1; i < points.size(); ++i)
+        path.lineTo(points[i]);
+    return path;
+}
+
+std::vector<FreehandStroke::Segment> FreehandStroke::simplify(const std::vector<juce::Point<float>>& points, float tolerance,
+                                                              juce::Range<float> controlRange) {
+    ///one shot version for a complete point list, e.g. an extracted envelope
+    std::vector<Segment> result;
+    if (points.size() < 2)
+        return result;
+    
+    std::vector<int> breaks;
+    std::vector<std::pair<int, int>> stack;
+    douglasPeucker(points, 0, (int) points.size() - 1, tolerance, breaks, stack);
+    mergeSegments(points, breaks, tolerance, controlRange, result);
+    return result;
+}
+
+void FreehandStroke::simplifyTail() {
+    ///only the part after the last committed anchor is simplified again,
+    ///breakpoints that are followed by another one won't move anymore and get committed
+    ///so the work per mouse event stays bounded no matter how long the stroke gets
+    const int first = anchors.back();
+    const int last = (int) points.size() - 1;
+    if (last - first < 2)
+        return;
+    
+    douglasPeucker(points, first, last, tolerance, tailBreaks, rangeStack);
+    
+    //tailBreaks = first, ..., last; everything but the last inner break is stable
+    for (size_t i = 1; i + 2 < tailBreaks.size(); ++i)
+        anchors.push_back(tailBreaks[i]);
+}
+
+void FreehandStroke::rebuildSegments() {
+    segments.clear();
+    if (points.size() < 2)
+        return;
+    
+    //close the open tail
+    const int last = (int) points.size() - 1;
+    douglasPeucker(points, anchors.back(), last, tolerance, tailBreaks, rangeStack);
+    for (size_t i = 1; i < tailBreaks.size(); ++i)
+        anchors.push_back(tailBreaks[i]);
+    
+    mergeSegments(points, anchors, tolerance, controlRange, segments);
+}
+
+void FreehandStroke::douglasPeucker(const std::vector<juce::Point<float>>& points, int first, int last, float tolerance,
+                                    std::vector<int>& breaks, std::vector<std::pair<int, int>>& stack) {
+    ///iterative RDP on [first, last], writes the sorted breakpoints including both ends into breaks
+    breaks.clear();
+    stack.clear();
+    breaks.push_back(first);
+    stack.push_back({ first, last });
+    
+    while (!stack.empty()) {
+        auto [a, b] = stack.back();
+        stack.pop_back();
+        
+        juce::Line<float> chord(points[a], points[b]);
+        float maxDistance = 0.0f;
+        int maxIndex = -1;
+        for (int i = a + 1; i < b; ++i) {
+            float distance = chord.getDistanceFromPoint(points[i]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                maxIndex = i;
+            }
+        }
+        
+        if (maxIndex >= 0 && maxDistance > tolerance) {
+            //right half first so the left one is popped next and breaks stay sorted
+            stack.push_back({ maxIndex, b });
+            stack.push_back({ a, maxIndex });
+        } else {
+            breaks.push_back(b);
+        }
+    }
+}
+
+float FreehandStroke::fitQuadratic(const std::vector<juce::Point<float>>& points, int first, int last,
+                                   juce::Range<float> controlRange, float& controlY) {
+    ///least squares fit of the control y of a quadratic bezier with fixed ends,
+    ///parameterized by x like the Modulator evaluates it, returns the largest deviation
+    ///the control point is limited to where the graph can put it before the error is measured,
+    ///so a peak the graph can't reach gets split instead of flattened
+    const auto& p0 = points[first];
+    const auto& p2 = points[last];
+    const float width = juce::jmax(1e-5f, p2.getX() - p0.getX());
+    
+    float numerator = 0.0f;
+    float denominator = 0.0f;
+    for (int i = first + 1; i < last; ++i) {
+        float alpha = (points[i].getX() - p0.getX()) / width;
+        float b0 = (1 - alpha) * (1 - alpha);
+        float b1 = 2 * (1 - alpha) * alpha;
+        float b2 = alpha * alpha;
+        numerator += b1 * (points[i].getY() - b0 * p0.getY() - b2 * p2.getY());
+        denominator += b1 * b1;
+    }
+    controlY = denominator > 0.0f ? numerator / denominator : (p0.getY() + p2.getY()) * 0.5f;
+    controlY = controlRange.clipValue(controlY);
+    
+    float maxError = 0.0f;
+    for (int i = first + 1; i < last; ++i) {
+        float alpha = (points[i].getX() - p0.getX()) / width;
+        float y = (1 - alpha) * (1 - alpha) * p0.getY() + 2 * (1 - alpha) * alpha * controlY + alpha * alpha * p2.getY();
+        maxError = juce::jmax(maxError, std::abs(y - points[i].getY()));
+    }
+    return maxError;
+}
+
+void FreehandStroke::mergeSegments(const std::vector<juce::Point<float>>& points, const std::vector<int>& breaks,
+                                   float tolerance, juce::Range<float> controlRange, std::vector<Segment>& result) {
+    ///greedily extend each segment over the following RDP pieces while a single quadratic still fits
+    result.clear();
+    size_t start = 0;
+    while (start + 1 < breaks.size()) {
+        size_t end = start + 1;
+        float controlY;
+        fitQuadratic(points, breaks[start], breaks[end], controlRange, controlY);
+        
+        while (end + 1 < breaks.size()) {
+            float extendedControlY;
+            if (fitQuadratic(points, breaks[start], breaks[end + 1], controlRange, extendedControlY) > tolerance)
+                break;
+            controlY = extendedControlY;
+            ++end;
+        }
+        
+        result.push_back({ points[breaks[start]], controlY, points[breaks[end]] });
+        start = end;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    FreehandStroke.h
+    Created: 18 Oct 2026 4:31:18pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+
+
+///collects mouse points of a freehand stroke and simplifies them while drawing
+///points are reduced with Ramer-Douglas-Peucker, neighbouring pieces are then merged
+///as long as one quadratic segment still fits them within the tolerance
+class FreehandStroke {
+    
+public:
+    
+    ///one simplified piece, the control point sits at the middle in x like an unbent ShapeEdge
+    struct Segment {
+        juce::Point<float> start;
+        float controlY;
+        juce::Point<float> end;
+    };
+    
+    void begin(juce::Point<float> point);
+    void addPoint(juce::Point<float> point);
+    void finish();
+    void clear();
+    
+    bool isActive() const;
+    void setTolerance(float newTolerance);
+    void setControlRange(juce::Range<float> newControlRange);
+    
+    const std::vector<Segment>& getSegments() const;
+    juce::Path createPreviewPath() const;
+    
+    static std::vector<Segment> simplify(const std::vector<juce::Point<float>>& points, float tolerance,
+                                         juce::Range<float> controlRange = unboundedRange());
+    
+private:
+    
+    std::vector<juce::Point<float>> points;
+    std::vector<int> anchors;       //committed breakpoints, indices into points
+    std::vector<Segment> segments;
+    float tolerance = 2.0f;
+    juce::Range<float> controlRange = unboundedRange();     //where the graph can place a control point
+    bool active = false;
+    
+    //scratch buffers, reused between mouse events
+    std::vector<int> tailBreaks;
+    std::vector<std::pair<int, int>> rangeStack;
+    
+    void simplifyTail();
+    void rebuildSegments();
+    
+    static void douglasPeucker(const std::vector<juce::Point<float>>& points, int first, int last, float tolerance,
+                               std::vector<int>& breaks, std::vector<std::pair<int, int>>& stack);
+    static float fitQuadratic(const std::vector<juce::Point<float>>& points, int first, int last,
+                              juce::Range<float> controlRange, float& controlY);
+    static void mergeSegments(const std::vector<juce::Point<float>>& points, const std::vector<int>& breaks,
+                              float tolerance, juce::Range<float> controlRange, std::vector<Segment>& result);
+    
+    static juce::Range<float> unboundedRange() { return { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() }; }
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    LoadMeter.cpp
+    Created: 19 Oct 2026 12:41:09am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "LoadMeter.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+juce::uint64 LoadMeter::readCounter() {
+    ///the time stamp counter costs a few cycles, the system clock is the fallback elsewhere
+   #if JUCE_INTEL
+    return __rdtsc();
+   #else
+    return (juce::uint64) juce::Time::getHighResolutionTicks();
+   #endif
+}
+
+double LoadMeter::getCounterFrequency() {
+    ///the time stamp counter runs at a constant rate, measured once against the system clock
+   #if JUCE_INTEL
+    static const double frequency = [] {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCounter = readCounter();
+        const auto endTicks = startTicks + juce::Time::secondsToHighResolutionTicks(0.005);
+        while (juce::Time::getHighResolutionTicks() < endTicks) {}
+        const auto elapsedCounter = readCounter() - startCounter;
+        return (double) elapsedCounter / juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }();
+    return frequency;
+   #else
+    return (double) juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
+
+void LoadMeter::prepare(double sampleRate) {
+    counterFrequency = getCounterFrequency();
+    percentPerTick = (float) (100.0 * sampleRate / counterFrequency);
+}
+
+void LoadMeter::addBlock(juce::uint64 elapsed, int numSamples) {
+    if (numSamples <= 0)
+        return;
+
+    if (resetRequested.load(std::memory_order_relaxed)) {
+        maxPercent.store(0.0f, std::memory_order_relaxed);
+        maxTicks.store(0, std::memory_order_relaxed);
+        resetRequested.store(false, std::memory_order_relaxed);
+    }
+
+    const float percent = (float) elapsed * percentPerTick / (float) numSamples;
+    const int bin = juce::jmin(numBins - 1, (int) (percent * binsPerPercent));
+
+    //single writer, plain loads and stores are enough
+    bins[bin].store(bins[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sumBins.store(sumBins.load(std::memory_order_relaxed) + (juce::uint64) bin, std::memory_order_relaxed);
+    if (percent > maxPercent.load(std::memory_order_relaxed))
+        maxPercent.store(percent, std::memory_order_relaxed);
+    if (elapsed > maxTicks.load(std::memory_order_relaxed))
+        maxTicks.store(elapsed, std::memory_order_relaxed);
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+LoadMeter::Statistics LoadMeter::getStatistics() const {
+    ///the histogram is read while the audio thread writes, a block that lands in between shows up in the next call
+    Statistics statistics;
+    const auto blocks = numBlocks.load(std::memory_order_acquire) - baselineBlocks;
+    if (blocks == 0)
+        return statistics;
+
+    statistics.numBlocks = (juce::int64) blocks;
+    //bins hold the rounded down value, the centre of the bin is the better estimate
+    statistics.meanPercent = (float) ((double) (sumBins.load(std::memory_order_relaxed) - baselineSum) / (double) blocks + 0.5) / binsPerPercent;
+    statistics.maxPercent = maxPercent.load(std::memory_order_relaxed);
+    statistics.maxMicroseconds = (double) maxTicks.load(std::memory_order_relaxed) / counterFrequency * 1.0e6;
+
+    const auto target = (juce::uint64) std::ceil(0.99 * (double) blocks);
+    juce::uint64 count = 0;
+    for (int bin = 0; bin < numBins; ++bin) {
+        count += bins[bin].load(std::memory_order_relaxed) - baselineBins[bin];
+        if (count >= target) {
+            statistics.p99Percent = ((float) bin + 0.5f) / binsPerPercent;
+            break;
+        }
+    }
+    return statistics;
+}
+
+void LoadMeter::reset() {
+    for (int bin = 0; bin < numBins; ++bin)
+        baselineBins[bin] = bins[bin].load(std::memory_order_relaxed);
+    baselineSum = sumBins.load(std::memory_order_relaxed);
+    baselineBlocks = numBlocks.load(std::memory_order_acquire);
+    resetRequested = true;
+}
+
+juce::Result LoadMeter::dumpToFile(const juce::File& file) const {
+    ///statistics and the non-empty bins as json
+    const auto statistics = getStatistics();
+    auto* root = new juce::DynamicObject();
+    root->setProperty("blocks", statistics.numBlocks);
+    root->setProperty("meanPercent", statistics.meanPercent);
+    root->setProperty("p99Percent", statistics.p99Percent);
+    root->setProperty("maxPercent", statistics.maxPercent);
+    root->setProperty("maxMicroseconds", statistics.maxMicroseconds);
+
+    juce::Array<juce::var> histogram;
+    for (int bin = 0; bin < numBins; ++bin) {
+        const auto count = bins[bin].load(std::memory_order_relaxed) - baselineBins[bin];
+        if (count > 0)
+            histogram.add(juce::Array<juce::var> { (double) bin / binsPerPercent, (int) count });
+    }
+    root->setProperty("histogram", histogram);
+
+    if (!file.replaceWithText(juce::JSON::toString(juce::var(root))))
+        return juce::Result::fail("Couldn't write " + file.getFullPathName());
+    return juce::Result::ok();
+}
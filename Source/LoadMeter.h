@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+    Created: 19 Oct 2026 12:41:09am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+
+//on by default, building with 0 removes the measurement from processBlock completely
+#ifndef LFOTOOL_LOAD_METER
+ #define LFOTOOL_LOAD_METER 1
+#endif
+
+
+///measures how much of its real-time budget processBlock uses
+///the audio thread reads the time stamp counter at the start and end of a block and bumps one histogram bin,
+///nothing else, no locks and no read-modify-write instructions since it is the only writer
+///the message thread turns the histogram into mean, p99 and max
+class LoadMeter {
+
+public:
+
+    static constexpr int numBins = 1024;
+    static constexpr float binsPerPercent = 4.0f;    //0.25% steps, the last bin collects everything above 256%
+
+    struct Statistics {
+        juce::int64 numBlocks = 0;
+        float meanPercent = 0.0f;
+        float p99Percent = 0.0f;
+        float maxPercent = 0.0f;
+        double maxMicroseconds = 0.0;   //worst block in absolute time
+    };
+
+    class ScopedBlock {
+    public:
+        ScopedBlock(LoadMeter& meter, int numSamples) : meter(meter), numSamples(numSamples), start(readCounter()) {}
+        ~ScopedBlock() { meter.addBlock(readCounter() - start, numSamples); }
+    private:
+        LoadMeter& meter;
+        const int numSamples;
+        const juce::uint64 start;
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    //prepareToPlay, calibrates the counter the first time
+    void prepare(double sampleRate);
+
+    //message thread
+    Statistics getStatistics() const;
+    void reset();
+    juce::Result dumpToFile(const juce::File& file) const;
+
+    static juce::uint64 readCounter();
+    static double getCounterFrequency();
+
+private:
+
+    void addBlock(juce::uint64 elapsed, int numSamples);
+
+    //written by the audio thread only
+    std::array<std::atomic<juce::uint32>, numBins> bins {};
+    std::atomic<juce::uint64> numBlocks { 0 };
+    std::atomic<juce::uint64> sumBins { 0 };
+    std::atomic<float> maxPercent { 0.0f };
+    std::atomic<juce::uint64> maxTicks { 0 };
+
+    //set by the message thread, the audio thread clears the maxima when it sees it
+    std::atomic<bool> resetRequested { false };
+
+    //a reset only moves the baseline, the audio thread never has to clear the histogram
+    std::array<juce::uint32, numBins> baselineBins {};
+    juce::uint64 baselineBlocks = 0;
+    juce::uint64 baselineSum = 0;
+
+    double counterFrequency = 1.0;
+    float percentPerTick = 0.0f;    //for one sample, divided by the block length per block
+};
+
+#if LFOTOOL_LOAD_METER
+ #define LFOTOOL_LOAD_SCOPE(meter, numSamples) const LoadMeter::ScopedBlock loadMeterScope(meter, numSamples);
+#else
+ #define LFOTOOL_LOAD_SCOPE(meter, numSamples)
+#endif
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    ModulatedFilter.cpp
+    Created: 19 Oct 2026 6:02:14pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "ModulatedFilter.h"
+
+void ModulatedFilter::prepare(double sampleRate, int numChannels) {
+    ///the table covers minFrequency..maxFrequency evenly in octaves, frequencies above nyquist are clamped
+    gTable.resize(tableSize);
+    const float nyquistLimit = (float) sampleRate * 0.49f;
+    for (int i = 0; i < tableSize; ++i) {
+        const float position = (float) i / (tableSize - 1);
+        const float frequency = juce::jmin(nyquistLimit, minFrequency * std::exp2(position * getNumOctaves()));
+        gTable[i] = std::tan(juce::MathConstants<float>::pi * frequency / (float) sampleRate);
+    }
+    
+    states.assign((size_t) juce::jmax(1, numChannels), ChannelState());
+    for (int channel = 0; channel < (int) states.size(); ++channel)
+        setCoefficients(channel, frequencyToPosition(1000.0f), juce::MathConstants<float>::sqrt2 / 2.0f);
+}
+
+void ModulatedFilter::reset() {
+    for (auto& state : states) {
+        state.ic1 = 0.0f;
+        state.ic2 = 0.0f;
+    }
+}
+
+void ModulatedFilter::setType(Type newType) {
+    type = newType;
+}
+
+ModulatedFilter::Type ModulatedFilter::getType() const {
+    return type;
+}
+
+float ModulatedFilter::getNumOctaves() {
+    return std::log2(maxFrequency / minFrequency);
+}
+
+float ModulatedFilter::frequencyToPosition(float frequency) {
+    return juce::jlimit(0.0f, 1.0f, std::log2(juce::jmax(frequency, minFrequency) / minFrequency) / getNumOctaves());
+}
+
+void ModulatedFilter::setCoefficients(int channel, float cutoffPosition, float resonance) {
+    ///cutoffPosition in 0..1 on the log axis, resonance is the Q
+    if (!juce::isPositiveAndBelow(channel, (int) states.size()) || gTable.empty())
+        return;
+    
+    const float index = juce::jlimit(0.0f, (float) (tableSize - 1), cutoffPosition * (tableSize - 1));
+    const int lower = juce::jmin((int) index, tableSize - 2);
+    const float g = gTable[lower] + (index - lower) * (gTable[lower + 1] - gTable[lower]);
+    
+    auto& state = states[(size_t) channel];
+    state.k = 1.0f / juce::jlimit(0.1f, maxResonance, resonance);
+    state.a1 = 1.0f / (1.0f + g * (g + state.k));
+    state.a2 = g * state.a1;
+    state.a3 = g * state.a2;
+}
+
+float ModulatedFilter::processSample(int channel, float input) {
+    ///TPT SVF by Andrew Simper, same as the crossover but for a single channel
+    auto& state = states[(size_t) channel];
+    const float v3 = input - state.ic2;
+    const float v1 = state.a1 * state.ic1 + state.a2 * v3;
+    const float v2 = state.ic2 + state.a2 * state.ic1 + state.a3 * v3;
+    state.ic1 = 2.0f * v1 - state.ic1;
+    state.ic2 = 2.0f * v2 - state.ic2;
+    
+    switch (type) {
+        case Type::Bandpass: return v1;
+        case Type::Highpass: return input - state.k * v1 - v2;
+        case Type::Lowpass:
+        default:             return v2;
+    }
+}
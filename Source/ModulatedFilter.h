@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    ModulatedFilter.h
+    Created: 19 Oct 2026 6:02:14pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <vector>
+
+
+///state variable filter whose cutoff follows the shape
+///the cutoff is given as a position on a log frequency axis and mapped through a precomputed tan() table,
+///coefficients are only updated every updateInterval samples, so modulating costs a lookup per sub-block
+class ModulatedFilter {
+    
+public:
+    
+    enum class Type { Lowpass, Bandpass, Highpass };
+    
+    static constexpr int updateInterval = 16;
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float maxFrequency = 20000.0f;
+    static constexpr float maxResonance = 10.0f;
+    
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+    void setType(Type newType);
+    Type getType() const;
+    void setCoefficients(int channel, float cutoffPosition, float resonance);
+    float processSample(int channel, float input);
+    
+    static float frequencyToPosition(float frequency);
+    static float getNumOctaves();
+    
+private:
+    
+    static constexpr int tableSize = 1024;
+    
+    struct ChannelState {
+        float ic1 = 0.0f, ic2 = 0.0f;
+        float a1 = 0.0f, a2 = 0.0f, a3 = 0.0f, k = 1.0f;
+    };
+    
+    Type type = Type::Lowpass;
+    std::vector<float> gTable;
+    std::vector<ChannelState> states;
+};
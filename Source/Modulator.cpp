@@ -9,33 +9,35 @@
 */
 
 #include "Modulator.h"
+#include "TraceRecorder.h"
 #include <juce_core/juce_core.h>
 
 Modulator::Modulator() {
     resolution = 2048;
-    modulationValues = std::make_shared<std::vector<float>>(resolution, 1.0f); // safe default
+    currentTable = std::make_shared<ModulationTable>(resolution, 1.0f); // safe default
+    publishedTable.store(currentTable.get());
 }
 
-void Modulator::generateModulationValues(const ShapeGraph* shapeGraph) {
+std::vector<ModulationSegment> Modulator::createSegments(const ShapeGraph* shapeGraph) {
+    ///convert the edges of the graph into normalized segments, this is the only part that touches the graph
+    std::vector<ModulationSegment> segments;
     if (shapeGraph == nullptr || shapeGraph->edges.size() == 0)
-        return;
-
-    auto newValues = std::make_shared<std::vector<float>>(resolution, 0.0f);
+        return segments;
 
     float minX = shapeGraph->getLeftBound();
     float minY = shapeGraph->getTopBound();
     float normX = shapeGraph->getRightBound() - minX;
     float normY = shapeGraph->getBottomBound() - minY;
+    //a graph restored from a broken session may have no extent, there is nothing sensible to build then
+    if (!(normX > 0.0f) || !(normY > 0.0f))
+        return segments;
 
-    // Precompute all segments (x0, x1, x2, y0, y1, y2)
-    struct Segment {
-        float x0, x1, x2;
-        float y0, y1, y2;
-    };
-    std::vector<Segment> segments;
+    segments.reserve(shapeGraph->edges.size());
 
     for (int i = 0; i < shapeGraph->edges.size(); ++i) {
         auto* edge = shapeGraph->edges[i];
+        if (!juce::isPositiveAndBelow(edge->from, shapeGraph->nodes.size()) || !juce::isPositiveAndBelow(edge->to, shapeGraph->nodes.size()))
+            continue;
         auto rect1 = shapeGraph->nodes[edge->from]->rect;
         auto rect2 = edge->rect;
         auto rect3 = shapeGraph->nodes[edge->to]->rect;
@@ -50,47 +52,287 @@ void Modulator::generateModulationValues(const ShapeGraph* shapeGraph) {
         // avoid division-by-zero in alpha later
         if (std::abs(x2 - x0) < 1e-5f)
             x2 = x0 + 1e-5f;
+        if (!std::isfinite(x0 + x1 + x2 + y0 + y1 + y2))
+            continue;
+
+        segments.push_back({ x0, x1, x2, y0, y1, y2, edge->type, SegmentShapes::tensionFromHandle(y0, y1, y2) });
+    }
+
+    return segments;
+}
+
+void Modulator::fillModulationValues(const std::vector<ModulationSegment>& segments, ModulationTable& table) const {
+    LFOTOOL_TRACE_SCOPE("fillModulationValues")
+    ///evaluate the segments into a table of size resolution, the table has to be preallocated
+    ///every segment only visits the entries inside its own x range, the segment type is loop invariant
+    ///so the compiler can hoist the switch and vectorize the remaining arithmetic
+    ///segments are walked back to front, so where two segments share an entry the earlier one wins as before
+    auto& values = table.values;
+    auto& hard = table.hard;
+    jassert(values.size() == (size_t) resolution);
+    std::fill(values.begin(), values.end(), 0.0f);
+    std::fill(hard.begin(), hard.end(), 0);
+
+    const float scale = (float) (resolution - 1);
+
+    for (int s = (int) segments.size() - 1; s >= 0; --s) {
+        const auto& seg = segments[s];
+        //limited before the int conversion, a segment far outside the table must not overflow it
+        const int first = juce::jmax(0, (int) std::ceil(juce::jlimit(-1.0f, 2.0f, seg.x0) * scale));
+        const int last = juce::jmin(resolution - 1, (int) std::floor(juce::jlimit(-1.0f, 2.0f, seg.x2) * scale));
+        const float width = seg.x2 - seg.x0;
+
+        for (int i = first; i <= last; ++i) {
+            float phase = (float)i / scale;
+            float alpha = juce::jlimit(0.0f, 1.0f, (phase - seg.x0) / width);
+            float y = SegmentShapes::evaluate(seg.type, seg.y0, seg.y1, seg.y2, seg.tension, alpha);
+            values[i] = juce::jlimit(0.0f, 1.0f, y);
+        }
+
+        //steps are applied without smoothing, including the first entry after the jump
+        if (seg.type == SegmentType::Hold) {
+            for (int i = first; i <= juce::jmin(resolution - 1, last + 1); ++i)
+                hard[i] = 1;
+        }
+    }
+}
+
+void Modulator::buildMipLevels(ModulationTable& table, juce::dsp::FFT& fft, std::vector<float>& spectrum, std::vector<float>& scratch) const {
+    LFOTOOL_TRACE_SCOPE("buildMipLevels")
+    ///band-limit the table once per level by clearing the harmonics above its limit
+    ///fft has to be of size resolution, spectrum and scratch need 2 * resolution floats
+    jassert(fft.getSize() == resolution);
+    std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+    std::copy(table.values.begin(), table.values.end(), spectrum.begin());
+    fft.performRealOnlyForwardTransform(spectrum.data());
+
+    for (int level = 1; level < ModulationTable::numMipLevels; ++level) {
+        const int maxHarmonic = resolution >> (level + 1);
+        std::copy(spectrum.begin(), spectrum.end(), scratch.begin());
+
+        //bins are interleaved re/im, clear everything above maxHarmonic and its mirror
+        for (int bin = maxHarmonic + 1; bin < resolution - maxHarmonic; ++bin) {
+            scratch[2 * bin] = 0.0f;
+            scratch[2 * bin + 1] = 0.0f;
+        }
 
-        segments.push_back({ x0, x1, x2, y0, y1, y2 });
+        fft.performRealOnlyInverseTransform(scratch.data());
+        std::copy(scratch.begin(), scratch.begin() + resolution, table.mipLevels[level].begin());
     }
+}
 
-    for (int i = 0; i < resolution; ++i) {
-        float phase = (float)i / (resolution - 1);
+void Modulator::publishModulationValues(std::shared_ptr<ModulationTable> table) {
+    ///swap the pointer the readers see, the old table is kept alive until no slot holds it anymore
+    if (table == nullptr)
+        return;
+    
+    const juce::ScopedLock sl(ownerLock);
+    if (currentTable != nullptr)
+        retiredTables.push_back(std::move(currentTable));
+    currentTable = std::move(table);
+    publishedTable.store(currentTable.get());
+    releaseUnusedTables();
+}
 
-        // find the segment that contains this phase
-        for (int s = 0; s < segments.size(); ++s) {
-            const auto& seg = segments[s];
-            if (phase >= seg.x0 && phase <= seg.x2) {
-                float alpha = (phase - seg.x0) / (seg.x2 - seg.x0);
+void Modulator::releaseRetiredTables() {
+    ///called by the compiler before it looks for a free pool table, a publish releases them as well
+    const juce::ScopedLock sl(ownerLock);
+    releaseUnusedTables();
+}
 
-                float y = (1 - alpha) * (1 - alpha) * seg.y0
-                        + 2 * (1 - alpha) * alpha * seg.y1
-                        + alpha * alpha * seg.y2;
+void Modulator::releaseUnusedTables() {
+    //a reader that loaded a retired table but hasn't put it into its slot yet checks the published pointer again and drops it
+    for (size_t i = 0; i < retiredTables.size();) {
+        const auto* table = retiredTables[i].get();
+        const bool inUse = std::any_of(readSlots.begin(), readSlots.end(), [table](const auto& slot) { return slot.load() == table; });
+        if (inUse) {
+            ++i;
+        } else {
+            retiredTables[i] = std::move(retiredTables.back());
+            retiredTables.pop_back();
+        }
+    }
+}
 
-                newValues->at(i) = juce::jlimit(0.0f, 1.0f, y);
-                break;
-            }
+Modulator::TableReference::TableReference(Modulator& modulator) {
+    ///claim a free slot, then publish the table in it and make sure it is still the current one
+    auto* current = modulator.publishedTable.load();
+    for (auto& candidate : modulator.readSlots) {
+        ModulationTable* expected = nullptr;
+        if (candidate.compare_exchange_strong(expected, current)) {
+            slot = &candidate;
+            break;
         }
     }
+    //more nested readers than slots, callers treat it like a missing table
+    jassert(slot != nullptr);
+    if (slot == nullptr)
+        return;
+    
+    for (;;) {
+        auto* latest = modulator.publishedTable.load();
+        if (latest == current)
+            break;
+        current = latest;
+        slot->store(current);
+    }
+    table = current;
+}
+
+Modulator::TableReference::TableReference(TableReference&& other) noexcept : slot(other.slot), table(other.table) {
+    other.slot = nullptr;
+    other.table = nullptr;
+}
+
+Modulator::TableReference& Modulator::TableReference::operator=(TableReference&& other) noexcept {
+    if (this != &other) {
+        reset();
+        std::swap(slot, other.slot);
+        std::swap(table, other.table);
+    }
+    return *this;
+}
+
+Modulator::TableReference::~TableReference() {
+    reset();
+}
+
+void Modulator::TableReference::reset() {
+    if (slot != nullptr)
+        slot->store(nullptr);
+    slot = nullptr;
+    table = nullptr;
+}
+
+int Modulator::getResolution() const {
+    return resolution;
+}
+
+void Modulator::generateModulationValues(const ShapeGraph* shapeGraph) {
+    LFOTOOL_TRACE_SCOPE("generateModulationValues")
+    ///synchronous version, allocates a new table on the calling thread
+    auto segments = createSegments(shapeGraph);
+    if (segments.empty())
+        return;
+
+    auto newTable = std::make_shared<ModulationTable>(resolution);
+    fillModulationValues(segments, *newTable);
+
+    juce::dsp::FFT fft(juce::roundToInt(std::log2(resolution)));
+    std::vector<float> spectrum(2 * resolution), scratch(2 * resolution);
+    buildMipLevels(*newTable, fft, spectrum, scratch);
 
-    std::atomic_store(&modulationValues, newValues);
+    publishModulationValues(newTable);
 }
 
 ///get the modulated value at phase point x on the curve
 
 float Modulator::getModulationValue(float phase)
 {
-    auto values = std::atomic_load(&modulationValues);
-    if (!values || values->empty())
+    bool hardEdge;
+    return getModulationValue(phase, hardEdge);
+}
+
+float Modulator::getModulationValue(float phase, bool& hardEdge)
+{
+    return getModulationValue(phase, 0.0f, hardEdge);
+}
+
+float Modulator::getMipLevel(double phaseIncrement) const {
+    ///level 0 is fine as long as its highest harmonic stays below nyquist, every level above halves the harmonics
+    ///the result is the exact band limit, readTable rounds it up to the next level that stays below it
+    const double level = std::log2(std::abs(phaseIncrement) * resolution);
+    if (!(level > 0.0))
+        return 0.0f;
+    return (float) juce::jmin(level, (double) (ModulationTable::numMipLevels - 1));
+}
+
+float Modulator::getModulationValue(float phase, float mipLevel, bool& hardEdge)
+{
+    TableReference table(*this);
+    hardEdge = false;
+    if (!table || table->values.empty())
         return 1.0f;
 
-    int index = juce::jlimit(0, resolution - 1, static_cast<int>(std::fmod(phase, 1.0f) * resolution));
-    return (*values)[index];
+    return readTable(*table, phase, mipLevel, hardEdge);
+}
+
+double Modulator::renderModulation(float* destination, int numSamples, double phase, double phaseIncrement, float mipLevel)
+{
+    ///render a block of modulation values, the table is only looked up once per block
+    ///returns the phase after the last sample
+    TableReference table(*this);
+    if (!table || table->values.empty()) {
+        juce::FloatVectorOperations::fill(destination, 1.0f, numSamples);
+        return phase;
+    }
+
+    bool hardEdge;
+    for (int i = 0; i < numSamples; ++i) {
+        destination[i] = readTable(*table, (float) phase, mipLevel, hardEdge);
+        phase += phaseIncrement;
+        if (phase >= 1.0)
+            phase -= 1.0;
+    }
+    return phase;
+}
+
+void Modulator::shapeBlock(float* samples, float* scratch, int numSamples, float mix)
+{
+    ///use the shape as a transfer function, the input in -1..1 picks the position on the curve
+    ///the index math runs through the vector ops, the lookup loop has no branches so it can become a gather
+    TableReference table(*this);
+    if (!table || table->values.empty())
+        return;
+
+    //the upper clip keeps index + 1 inside the table
+    const float scale = 0.5f * (float) (resolution - 1);
+    juce::FloatVectorOperations::copy(scratch, samples, numSamples);
+    juce::FloatVectorOperations::multiply(scratch, scale, numSamples);
+    juce::FloatVectorOperations::add(scratch, scale, numSamples);
+    juce::FloatVectorOperations::clip(scratch, scratch, 0.0f, (float) (resolution - 1) - 1.0e-3f, numSamples);
+
+    const float* values = table->values.data();
+    for (int i = 0; i < numSamples; ++i) {
+        const int index = (int) scratch[i];
+        const float fraction = scratch[i] - (float) index;
+        const float shaped = values[index] + fraction * (values[index + 1] - values[index]);
+        samples[i] += mix * ((2.0f * shaped - 1.0f) - samples[i]);
+    }
+}
+
+float Modulator::readTable(const ModulationTable& table, float phase, float mipLevel, bool& hardEdge) const
+{
+    ///slow rates read the plain table like before, fast rates interpolate the first level whose harmonics all stay
+    ///below nyquist, a fractional level is rounded up, rounding down would keep harmonics above the limit
+    ///that is one extra read per sample, crossfading to the next level as well would double it
+    if (mipLevel <= 0.0f) {
+        int index = juce::jlimit(0, resolution - 1, static_cast<int>(std::fmod(phase, 1.0f) * resolution));
+        hardEdge = table.hard[index] != 0;
+        return table.values[index];
+    }
+
+    hardEdge = false;
+    const int level = juce::jlimit(1, ModulationTable::numMipLevels - 1, (int) std::ceil(mipLevel));
+
+    float position = std::fmod(phase, 1.0f) * resolution;
+    if (position < 0.0f)
+        position += resolution;
+    const int index = juce::jlimit(0, resolution - 1, (int) position);
+    const int next = (index + 1) % resolution;
+    const float fraction = position - index;
+
+    const auto& values = table.mipLevels[(size_t) level];
+    return values[(size_t) index] + fraction * (values[(size_t) next] - values[(size_t) index]);
+}
+
+Modulator::TableReference Modulator::getTable() {
+    return TableReference(*this);
 }
 
 float Modulator::getLastModulationValue()   {
-    auto values = std::atomic_load(&modulationValues);
-    if (!values || values->empty())
+    TableReference table(*this);
+    if (!table || table->values.empty())
             return 1.0f;
-    return (*values)[resolution - 1];
+    return table->values[resolution - 1];
 }
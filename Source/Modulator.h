@@ -12,21 +12,103 @@
 #include "juce_core/juce_core.h"
 #include "juce_gui_basics/juce_gui_basics.h"
 #include "ShapeGraph.h"
+#include "SegmentShapes.h"
 #include "juce_dsp/juce_dsp.h"
 
 
+///one segment of the shape, normalized to 0..1 in both directions
+struct ModulationSegment {
+    float x0, x1, x2;
+    float y0, y1, y2;
+    SegmentType type;
+    float tension;
+};
+
+///evaluated shape, hard marks the entries where the value has to jump without smoothing
+///mipLevels holds band-limited copies for fast rates, level l keeps resolution / 2^(l+1) harmonics
+///level 0 is values itself, so mipLevels[0] stays empty
+struct ModulationTable {
+    static constexpr int numMipLevels = 11;
+    
+    std::vector<float> values;
+    std::vector<juce::uint8> hard;
+    std::vector<std::vector<float>> mipLevels;
+    
+    explicit ModulationTable(int resolution, float initialValue = 0.0f) : values(resolution, initialValue), hard(resolution, 0), mipLevels(numMipLevels) {
+        for (int level = 1; level < numMipLevels; ++level)
+            mipLevels[level].resize(resolution, initialValue);
+    }
+};
+
+
 class Modulator {
     
+public:
+    
+    ///read access to the published table, a table can't be released while a reference to it exists
+    ///taking one is lock-free and never allocates, so it is the way the audio thread reads the table
+    class TableReference {
+    public:
+        TableReference() = default;
+        explicit TableReference(Modulator& modulator);
+        TableReference(TableReference&& other) noexcept;
+        TableReference& operator=(TableReference&& other) noexcept;
+        ~TableReference();
+        
+        void reset();
+        const ModulationTable* get() const { return table; }
+        const ModulationTable* operator->() const { return table; }
+        const ModulationTable& operator*() const { return *table; }
+        explicit operator bool() const { return table != nullptr; }
+        bool operator==(std::nullptr_t) const { return table == nullptr; }
+        bool operator!=(std::nullptr_t) const { return table != nullptr; }
+        
+    private:
+        std::atomic<ModulationTable*>* slot = nullptr;
+        const ModulationTable* table = nullptr;
+        JUCE_DECLARE_NON_COPYABLE(TableReference)
+    };
+    
 private:
     
+    //more than one reference is held at a time when a block reads the table and a sample read nests inside
+    static constexpr int numReadSlots = 4;
+    
     int resolution;
-    std::shared_ptr<std::vector<float>> modulationValues;
+    
+    ///hazard pointers: readers put the table they use into a slot, the publishing side only lets go of
+    ///retired tables that are in no slot, so the last reference is never dropped on the audio thread
+    std::atomic<ModulationTable*> publishedTable { nullptr };
+    std::array<std::atomic<ModulationTable*>, numReadSlots> readSlots {};
+    
+    //owned by the publishing side (message and compiler thread)
+    juce::CriticalSection ownerLock;
+    std::shared_ptr<ModulationTable> currentTable;
+    std::vector<std::shared_ptr<ModulationTable>> retiredTables;
+    
+    void releaseUnusedTables();
     
 public:
     
     Modulator();
     
+    static std::vector<ModulationSegment> createSegments(const ShapeGraph* shapeGraph);
+    void fillModulationValues(const std::vector<ModulationSegment>& segments, ModulationTable& table) const;
+    void buildMipLevels(ModulationTable& table, juce::dsp::FFT& fft, std::vector<float>& spectrum, std::vector<float>& scratch) const;
+    void publishModulationValues(std::shared_ptr<ModulationTable> table);
+    void releaseRetiredTables();
+    int getResolution() const;
+    
     void generateModulationValues(const ShapeGraph* shapeGraph);
     float getModulationValue(float phase);
+    float getModulationValue(float phase, bool& hardEdge);
+    float getModulationValue(float phase, float mipLevel, bool& hardEdge);
+    float getMipLevel(double phaseIncrement) const;
+    double renderModulation(float* destination, int numSamples, double phase, double phaseIncrement, float mipLevel);
+    void shapeBlock(float* samples, float* scratch, int numSamples, float mix);
     float getLastModulationValue();
+    
+    //for callers reading several modulators per sample: take the table once per block, then read it directly
+    TableReference getTable();
+    float readTable(const ModulationTable& table, float phase, float mipLevel, bool& hardEdge) const;
 };
@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    MultibandCrossover.cpp
+    Created: 19 Oct 2026 2:26:37pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "MultibandCrossover.h"
+
+void MultibandCrossover::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    glideCoefficient = 1.0f - std::exp(-(float) updateInterval / (0.02f * (float) sampleRate));
+    std::copy(std::begin(targetFrequencies), std::end(targetFrequencies), std::begin(frequencies));
+    gliding = false;
+    updateCountdown = 0;
+    updateCoefficients();
+    reset();
+}
+
+void MultibandCrossover::reset() {
+    for (auto* svf : { &splitA, &splitA2, &allpass, &splitB, &splitB2Low, &splitB2High })
+        svf->reset();
+}
+
+void MultibandCrossover::setNumBands(int newNumBands) {
+    newNumBands = juce::jlimit(1, maxBands, newNumBands);
+    if (newNumBands != numBands) {
+        //the filters start from silence anyway, no need to glide
+        numBands = newNumBands;
+        std::copy(std::begin(targetFrequencies), std::end(targetFrequencies), std::begin(frequencies));
+        gliding = false;
+        updateCoefficients();
+        reset();
+    }
+}
+
+void MultibandCrossover::setCrossoverFrequencies(float low, float mid, float high) {
+    ///sets where the splits glide to, so it can be called every block and automation doesn't zipper
+    //keep the splits ordered
+    mid = juce::jmax(mid, low);
+    high = juce::jmax(high, mid);
+    if (low == targetFrequencies[0] && mid == targetFrequencies[1] && high == targetFrequencies[2])
+        return;
+    
+    targetFrequencies[0] = low;
+    targetFrequencies[1] = mid;
+    targetFrequencies[2] = high;
+    gliding = true;
+}
+
+void MultibandCrossover::glideFrequencies() {
+    ///one step towards the targets, ratios so a glide sounds even over the whole range
+    gliding = false;
+    for (int i = 0; i < 3; ++i) {
+        const float ratio = targetFrequencies[i] / frequencies[i];
+        if (std::abs(ratio - 1.0f) < 1.0e-4f) {
+            frequencies[i] = targetFrequencies[i];
+        } else {
+            frequencies[i] *= std::pow(ratio, glideCoefficient);
+            gliding = true;
+        }
+    }
+    //the glides run at the same speed, so the ratios keep the splits ordered
+    updateCoefficients();
+}
+
+float MultibandCrossover::toG(float frequency) const {
+    const float limited = juce::jlimit(10.0f, (float) (sampleRate * 0.49), frequency);
+    return std::tan(juce::MathConstants<float>::pi * limited / (float) sampleRate);
+}
+
+void MultibandCrossover::updateCoefficients() {
+    ///which split runs on which lanes depends on the band count, see process()
+    const float f1 = toG(frequencies[0]);
+    const float f2 = toG(frequencies[1]);
+    const float f3 = toG(frequencies[2]);
+    
+    if (numBands == 4) {
+        //first split in the middle, then both halves in parallel
+        const float first[4] = { f2, f2, f2, f2 };
+        const float compensate[4] = { f3, f3, f1, f1 };
+        const float second[4] = { f1, f1, f3, f3 };
+        splitA.setCutoff(first);
+        splitA2.setCutoff(first);
+        allpass.setCutoff(compensate);
+        splitB.setCutoff(second);
+        splitB2Low.setCutoff(second);
+        splitB2High.setCutoff(second);
+    } else {
+        //split at f1, a third band splits the upper part at f2 while the lower one gets the allpass on the same lanes
+        const float first[4] = { f1, f1, f1, f1 };
+        const float second[4] = { f2, f2, f2, f2 };
+        splitA.setCutoff(first);
+        splitA2.setCutoff(first);
+        splitB.setCutoff(second);
+        splitB2Low.setCutoff(second);
+    }
+}
+
+void MultibandCrossover::process(float left, float right, float (&bands)[maxBands][2]) {
+    FloatLanes lp, bp, hp, lp2, bp2, hp2;
+    
+    if (numBands <= 1) {
+        bands[0][0] = left;
+        bands[0][1] = right;
+        return;
+    }
+    
+    if (gliding && --updateCountdown <= 0) {
+        updateCountdown = updateInterval;
+        glideFrequencies();
+    }
+    
+    //first split: lanes 0/1 carry the channels, the cascade runs lowpass on 0/1 and highpass on 2/3
+    splitA.tick({ { left, right, left, right } }, lp, bp, hp);
+    splitA2.tick(FloatLanes::blend(lp, hp), lp2, bp2, hp2);
+    const FloatLanes split = FloatLanes::blend(lp2, hp2);   //low on 0/1, high on 2/3
+    
+    if (numBands == 2) {
+        bands[0][0] = split.v[0];
+        bands[0][1] = split.v[1];
+        bands[1][0] = split.v[2];
+        bands[1][1] = split.v[3];
+        return;
+    }
+    
+    if (numBands == 3) {
+        //upper part splits at f2 on lanes 0/1, the low band takes the allpass at f2 on lanes 2/3
+        const FloatLanes input = { { split.v[2], split.v[3], split.v[0], split.v[1] } };
+        splitB.tick(input, lp, bp, hp);
+        const FloatLanes compensated = input - FloatLanes::broadcast(2.0f * k) * bp;
+        splitB2Low.tick({ { lp.v[0], lp.v[1], hp.v[0], hp.v[1] } }, lp2, bp2, hp2);
+        
+        bands[0][0] = compensated.v[2];
+        bands[0][1] = compensated.v[3];
+        bands[1][0] = lp2.v[0];
+        bands[1][1] = lp2.v[1];
+        bands[2][0] = hp2.v[2];
+        bands[2][1] = hp2.v[3];
+        return;
+    }
+    
+    //4 bands: the low half gets the allpass of f3, the high half the one of f1, then both split at once
+    allpass.tick(split, lp, bp, hp);
+    const FloatLanes compensated = split - FloatLanes::broadcast(2.0f * k) * bp;
+    
+    splitB.tick(compensated, lp, bp, hp);
+    splitB2Low.tick(lp, lp2, bp2, hp2);
+    FloatLanes lowParts = lp2;
+    splitB2High.tick(hp, lp2, bp2, hp2);
+    FloatLanes highParts = hp2;
+    
+    bands[0][0] = lowParts.v[0];
+    bands[0][1] = lowParts.v[1];
+    bands[1][0] = highParts.v[0];
+    bands[1][1] = highParts.v[1];
+    bands[2][0] = lowParts.v[2];
+    bands[2][1] = lowParts.v[3];
+    bands[3][0] = highParts.v[2];
+    bands[3][1] = highParts.v[3];
+}
+
+void MultibandCrossover::Svf::setCutoff(const float (&g)[4]) {
+    for (int i = 0; i < 4; ++i) {
+        a1.v[i] = 1.0f / (1.0f + g[i] * (g[i] + k));
+        a2.v[i] = g[i] * a1.v[i];
+        a3.v[i] = g[i] * a2.v[i];
+    }
+}
+
+void MultibandCrossover::Svf::reset() {
+    ic1 = FloatLanes::broadcast(0.0f);
+    ic2 = FloatLanes::broadcast(0.0f);
+}
+
+void MultibandCrossover::Svf::tick(const FloatLanes& x, FloatLanes& lowpass, FloatLanes& bandpass, FloatLanes& highpass) {
+    ///TPT SVF by Andrew Simper, all four lanes at once
+    const FloatLanes two = FloatLanes::broadcast(2.0f);
+    const FloatLanes v3 = x - ic2;
+    const FloatLanes v1 = a1 * ic1 + a2 * v3;
+    const FloatLanes v2 = ic2 + a2 * ic1 + a3 * v3;
+    ic1 = two * v1 - ic1;
+    ic2 = two * v2 - ic2;
+    
+    lowpass = v2;
+    bandpass = v1;
+    highpass = x - FloatLanes::broadcast(k) * v1 - v2;
+}
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    MultibandCrossover.h
+    Created: 19 Oct 2026 2:26:37pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include "SimdLanes.h"
+
+
+///stereo Linkwitz-Riley (4th order) crossover for 2 to 4 bands, the bands sum back to an allpass
+///every filter is a TPT state variable filter running on four lanes at once,
+///one SVF tick gives lowpass, highpass and the allpass needed for phase compensation together
+///lanes hold both channels of two branches, so 4 bands only need 6 ticks per sample
+///new crossover frequencies are glided to on a log axis, coefficients follow every updateInterval samples
+class MultibandCrossover {
+    
+public:
+    
+    static constexpr int maxBands = 4;
+    static constexpr int updateInterval = 16;
+    
+    void prepare(double sampleRate);
+    void reset();
+    void setNumBands(int numBands);
+    void setCrossoverFrequencies(float low, float mid, float high);
+    
+    void process(float left, float right, float (&bands)[maxBands][2]);
+    
+private:
+    
+    struct Svf {
+        FloatLanes a1, a2, a3;
+        FloatLanes ic1 = FloatLanes::broadcast(0.0f);
+        FloatLanes ic2 = FloatLanes::broadcast(0.0f);
+        
+        void setCutoff(const float (&g)[4]);
+        void reset();
+        void tick(const FloatLanes& x, FloatLanes& lowpass, FloatLanes& bandpass, FloatLanes& highpass);
+    };
+    
+    static constexpr float k = juce::MathConstants<float>::sqrt2;   //butterworth damping
+    
+    double sampleRate = 44100.0;
+    int numBands = 1;
+    float frequencies[3] = { 120.0f, 1000.0f, 5000.0f };          //the ones the coefficients are calculated from
+    float targetFrequencies[3] = { 120.0f, 1000.0f, 5000.0f };
+    bool gliding = false;
+    int updateCountdown = 0;
+    float glideCoefficient = 1.0f;      //per update, ~20ms time constant
+    
+    //split, split cascade, allpass, second split, second split cascades
+    Svf splitA, splitA2, allpass, splitB, splitB2Low, splitB2High;
+    
+    void updateCoefficients();
+    void glideFrequencies();
+    float toG(float frequency) const;
+};
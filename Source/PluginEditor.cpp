@@ -10,6 +10,7 @@
 #include "PluginEditor.h"
 #include "ShapeGraph.h"
 #include "Modulator.h"
+#include "TraceRecorder.h"
 #include <juce_data_structures/juce_data_structures.h>
 
 //==============================================================================
@@ -23,11 +24,34 @@ RectanglesAudioProcessorEditor::RectanglesAudioProcessorEditor (RectanglesAudioP
     addAndMakeVisible(syncButton);
     addAndMakeVisible(quantizeButton);
     addAndMakeVisible(scButton);
+    addAndMakeVisible(drawButton);
+    addAndMakeVisible(importButton);
+    addAndMakeVisible(modeBox);
+    addAndMakeVisible(oversamplingBox);
+    addAndMakeVisible(noteTrackButton);
+    addAndMakeVisible(bandsBox);
+    addChildComponent(bandSelector);
+    addChildComponent(bandDepthSlider);
+    addChildComponent(bandPhaseSlider);
+    addChildComponent(crossoverSlider);
+    addAndMakeVisible(destinationBox);
+    addChildComponent(filterTypeBox);
+    addChildComponent(cutoffSlider);
+    addChildComponent(filterRangeSlider);
+    addChildComponent(resonanceSlider);
+    addAndMakeVisible(ccOutputButton);
+    addChildComponent(scModeBox);
+    addChildComponent(scrubRangeSlider);
+    addChildComponent(scFilterBox);
+    addChildComponent(scFilterFreqSlider);
+    addChildComponent(scAuditionButton);
+    addChildComponent(scTriggerBox);
+    addChildComponent(transientSensitivitySlider);
     //addAndMakeVisible(scReleaseSlider);
     addAndMakeVisible(panOffsetSlider);
     //addAndMakeVisible(scWarningLabel);
     
-    lfoRateSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lfoRate", lfoRateSlider);
+    lfoRateSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "lfo rate", lfoRateSlider);
     syncButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "sync", syncButton);
     quantizeButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "quantize", quantizeButton);
     depthSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "depth", depthSlider);
@@ -36,6 +60,19 @@ RectanglesAudioProcessorEditor::RectanglesAudioProcessorEditor (RectanglesAudioP
     //scReleaseSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "sc release", scReleaseSlider);
     panOffsetSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "pan offset", panOffsetSlider);
     
+    //choices have to be in the box before the attachment is created
+    modeBox.addItemList(audioProcessor.parameters.getParameter("mode")->getAllValueStrings(), 1);
+    oversamplingBox.addItemList(audioProcessor.parameters.getParameter("oversampling")->getAllValueStrings(), 1);
+    modeBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "mode", modeBox);
+    oversamplingBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "oversampling", oversamplingBox);
+    noteTrackButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "note track", noteTrackButton);
+    bandsBox.addItemList(audioProcessor.parameters.getParameter("bands")->getAllValueStrings(), 1);
+    bandsBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "bands", bandsBox);
+    destinationBox.addItemList(audioProcessor.parameters.getParameter("destination")->getAllValueStrings(), 1);
+    filterTypeBox.addItemList(audioProcessor.parameters.getParameter("filter type")->getAllValueStrings(), 1);
+    destinationBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "destination", destinationBox);
+    filterTypeBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "filter type", filterTypeBox);
+    
     lfoRateSlider.setSliderStyle(juce::Slider::SliderStyle::RotaryVerticalDrag);
     lfoRateSlider.setColour(juce::Slider::rotarySliderFillColourId, juce::Colours::orange);
     lfoRateSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 100, 20); // false = no outline
@@ -99,11 +136,118 @@ RectanglesAudioProcessorEditor::RectanglesAudioProcessorEditor (RectanglesAudioP
     scThresholdLabel.setText("Threshold", juce::dontSendNotification);
     scThresholdLabel.attachToComponent(&scThresholdSlider, true);
     
+    //scrubbing replaces the threshold, the sidechain level is the position on the curve
+    scModeBox.addItemList(audioProcessor.parameters.getParameter("sc mode")->getAllValueStrings(), 1);
+    scModeBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "sc mode", scModeBox);
+    scModeBox.setTooltip("Sidechain resets the phase or scrubs through the shape");
+    scModeBox.onChange = [this] { scButtonClicked(); };
+    
+    scrubRangeSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    scrubRangeSlider.setColour(juce::Slider::thumbColourId, juce::Colours::orange);
+    scrubRangeSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    scrubRangeSlider.setVelocityBasedMode(true);
+    scrubRangeSlider.setScrollWheelEnabled(true);
+    scrubRangeSlider.setVelocityModeParameters(1.0, 0.5, 0.09, true);
+    scrubRangeSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "scrub range", scrubRangeSlider);
+    scrubRangeLabel.setText("Range", juce::dontSendNotification);
+    scrubRangeLabel.attachToComponent(&scrubRangeSlider, true);
+    
+    //keeps hats or bass bleed out of the detection
+    scFilterBox.addItemList(audioProcessor.parameters.getParameter("sc filter")->getAllValueStrings(), 1);
+    scFilterBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "sc filter", scFilterBox);
+    scFilterBox.setTooltip("Sidechain detection filter");
+    scFilterFreqSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    scFilterFreqSlider.setColour(juce::Slider::thumbColourId, juce::Colours::orange);
+    scFilterFreqSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    scFilterFreqSlider.setVelocityBasedMode(true);
+    scFilterFreqSlider.setScrollWheelEnabled(true);
+    scFilterFreqSlider.setVelocityModeParameters(1.0, 0.5, 0.09, true);
+    scFilterFreqSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "sc filter freq", scFilterFreqSlider);
+    scFilterFreqLabel.setText("Freq", juce::dontSendNotification);
+    scFilterFreqLabel.attachToComponent(&scFilterFreqSlider, true);
+    scAuditionButton.setButtonText("Listen");
+    scAuditionButton.setTooltip("Play the filtered sidechain instead of the output");
+    scAuditionButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "sc audition", scAuditionButton);
+    
+    //transients replace the threshold with a sensitivity
+    scTriggerBox.addItemList(audioProcessor.parameters.getParameter("sc trigger")->getAllValueStrings(), 1);
+    scTriggerBoxAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.parameters, "sc trigger", scTriggerBox);
+    scTriggerBox.setTooltip("Trigger on level or on transients");
+    scTriggerBox.onChange = [this] { scButtonClicked(); };
+    transientSensitivitySlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    transientSensitivitySlider.setColour(juce::Slider::thumbColourId, juce::Colours::orange);
+    transientSensitivitySlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    transientSensitivitySlider.setVelocityBasedMode(true);
+    transientSensitivitySlider.setScrollWheelEnabled(true);
+    transientSensitivitySlider.setVelocityModeParameters(1.0, 0.5, 0.09, true);
+    transientSensitivitySliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "transient sensitivity", transientSensitivitySlider);
+    transientSensitivityLabel.setText("Sensitivity", juce::dontSendNotification);
+    transientSensitivityLabel.attachToComponent(&transientSensitivitySlider, true);
+    
     scButton.setButtonText("sc");
     scButton.onClick = [this] {
         scButtonClicked();
     };
     
+    drawButton.setButtonText("Draw");
+    noteTrackButton.setButtonText("Note");
+    modeBox.setTooltip("Mode");
+    oversamplingBox.setTooltip("Oversampling in the audio rate modes");
+    
+    importButton.setButtonText("Import");
+    importButton.setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
+    importButton.onClick = [this] { importButtonClicked(); };
+    
+   #if LFOTOOL_LOAD_METER
+    addAndMakeVisible(loadMeterButton);
+    loadMeterButton.setColour(juce::TextButton::buttonColourId, juce::Colours::black.withAlpha(0.4f));
+    loadMeterButton.setColour(juce::TextButton::textColourOffId, juce::Colours::grey);
+    loadMeterButton.setTooltip("DSP load of this instance, click to reset or save");
+    loadMeterButton.onClick = [this] { loadMeterButtonClicked(); };
+   #endif
+    
+    bandsBox.setTooltip("Number of bands");
+    bandsBox.onChange = [this] { updateBandControls(); };
+    for(int band = 0; band < RectanglesAudioProcessor::maxBands; ++band)
+        bandSelector.addItem("Band " + juce::String(band + 1), band + 1);
+    bandSelector.setSelectedId(1, juce::dontSendNotification);
+    bandSelector.setTooltip("Band whose shape is edited");
+    bandSelector.onChange = [this] { selectBand(bandSelector.getSelectedId() - 1); };
+    
+    destinationBox.setTooltip("What the shape modulates");
+    destinationBox.onChange = [this] { updateFilterControls(); };
+    filterTypeBox.setTooltip("Filter type");
+    
+    for(auto* slider : { &bandDepthSlider, &bandPhaseSlider, &crossoverSlider, &cutoffSlider, &filterRangeSlider, &resonanceSlider }) {
+        slider->setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        slider->setColour(juce::Slider::thumbColourId, juce::Colours::orange);
+        slider->setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+        slider->setVelocityBasedMode(true);
+        slider->setScrollWheelEnabled(true);
+        slider->setVelocityModeParameters(1.0, 0.5, 0.1, true);
+    }
+    bandDepthLabel.setText("Depth", juce::dontSendNotification);
+    bandDepthLabel.attachToComponent(&bandDepthSlider, true);
+    bandPhaseLabel.setText("Phase", juce::dontSendNotification);
+    bandPhaseLabel.attachToComponent(&bandPhaseSlider, true);
+    crossoverLabel.setText("Split", juce::dontSendNotification);
+    crossoverLabel.attachToComponent(&crossoverSlider, true);
+    crossoverSlider.setTooltip("Crossover to the next band up");
+    cutoffLabel.setText("Cutoff", juce::dontSendNotification);
+    cutoffLabel.attachToComponent(&cutoffSlider, true);
+    filterRangeLabel.setText("Range", juce::dontSendNotification);
+    filterRangeLabel.attachToComponent(&filterRangeSlider, true);
+    filterRangeSlider.setTooltip("How many octaves the shape moves the cutoff up");
+    resonanceLabel.setText("Reso", juce::dontSendNotification);
+    resonanceLabel.attachToComponent(&resonanceSlider, true);
+    cutoffSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "cutoff", cutoffSlider);
+    filterRangeSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "filter range", filterRangeSlider);
+    resonanceSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "resonance", resonanceSlider);
+    
+    ccOutputButton.setButtonText("CC Out");
+    ccOutputButton.setTooltip("Send the modulation as MIDI CC");
+    ccOutputButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.parameters, "cc output", ccOutputButton);
+    
     /*scReleaseSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
     scReleaseSlider.setColour(juce::Slider::thumbColourId, juce::Colours::orange);
     scReleaseSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
@@ -123,67 +267,133 @@ RectanglesAudioProcessorEditor::RectanglesAudioProcessorEditor (RectanglesAudioP
     scWarningLabel.setColour(juce::Label::textColourId, juce::Colours::red);
     scWarningLabel.setVisible(false);*/
 
-    setSize (600, 500);
+    setSize (700, 560);
     
-    shapeGraph.setQuantizeDepth(8);
-    shapeGraph.setLeftBound(10);
-    shapeGraph.setTopBound(10);
-    shapeGraph.setWidth(getWidth()-20);
-    shapeGraph.setHeight(getHeight()-100);
-    shapeGraph.setRightBound(shapeGraph.getLeftBound() + shapeGraph.getWidth());
-    shapeGraph.setBottomBound(shapeGraph.getTopBound() + shapeGraph.getHeight());
+    audioProcessor.setLfoRate(lfoRateSlider.getValue());
     
-    if (audioProcessor.shapeGraphXmlString.isNotEmpty()) {
-        juce::XmlDocument doc(audioProcessor.shapeGraphXmlString);
-        std::unique_ptr<juce::XmlElement> xml(doc.getDocumentElement());
+    //every band gets its saved shape, or the default one so all bands have a table
+    for(int band = 0; band < RectanglesAudioProcessor::maxBands; ++band) {
+        editedBand = band;
+        shapeGraph = &bandShapeGraphs[band];
+        shapeHistory = &bandShapeHistories[band];
+        shapeGraph->setQuantizeDepth(8);
+        layoutShapeGraph(*shapeGraph);
+        
+        auto shapeGraphXmlString = audioProcessor.getShapeGraphXmlString(band);
+        if (shapeGraphXmlString.isNotEmpty()) {
+            juce::XmlDocument doc(shapeGraphXmlString);
+            std::unique_ptr<juce::XmlElement> xml(doc.getDocumentElement());
 
-        if (xml != nullptr)
-            shapeGraph.loadXML(*xml);
+            if (xml != nullptr)
+                shapeGraph->loadXML(*xml);
+        }
+        
+        publishShape();
+        shapeHistory->reset(*shapeGraph);
     }
-    
-    audioProcessor.setLfoRate(lfoRateSlider.getValue());
-    audioProcessor.updateLfoData(shapeGraph);
+    selectBand(0);
+    updateFilterControls();
+    setWantsKeyboardFocus(true);
     
     scButtonClicked();
     syncButtonClicked();
     bpm = audioProcessor.getBpm();
+    //the histories are only recorded while an editor shows them
+    audioProcessor.inputHistory.setEnabled(true);
+    audioProcessor.outputHistory.setEnabled(true);
     startTimerHz(30);
 }
 
 RectanglesAudioProcessorEditor::~RectanglesAudioProcessorEditor()
 {
+    audioProcessor.inputHistory.setEnabled(false);
+    audioProcessor.outputHistory.setEnabled(false);
 }
 
 //==============================================================================
 void RectanglesAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    LFOTOOL_TRACE_SCOPE("paint")
     g.fillAll (juce::Colours::black);
     
+    //draw the audio of the last cycles behind the shape
+    paintWaveformHistory(g, audioProcessor.inputHistory, juce::Colours::grey);
+    paintWaveformHistory(g, audioProcessor.outputHistory, juce::Colours::orange);
+    
     //draw shapeGraph
-    shapeGraph.paint(g);
+    shapeGraph->paint(g);
+    
+    //draw the stroke while it is being drawn
+    if(freehandStroke.isActive()) {
+        g.setColour(juce::Colours::white.withAlpha(0.8f));
+        g.strokePath(freehandStroke.createPreviewPath(), juce::PathStrokeType(1.5f));
+    }
+    
+    //show how far an audio import got
+    if(envelopeImporter.isImporting()) {
+        auto bar = importButton.getBounds().toFloat().withY(importButton.getBottom()-3).withHeight(3);
+        g.setColour(juce::Colours::orange);
+        g.fillRect(bar.withWidth(bar.getWidth() * envelopeImporter.getProgress()));
+    }
     
     //draw playhead
     g.setColour(juce::Colours::grey.withAlpha(0.5f));
     juce::Path path;
-    double xPos = shapeGraph.getLeftBound()+audioProcessor.getPhase()*shapeGraph.getWidth();
-    path.startNewSubPath(xPos, shapeGraph.getTopBound());
-    path.lineTo(xPos, shapeGraph.getBottomBound());
+    double xPos = shapeGraph->getLeftBound()+audioProcessor.getPhase()*shapeGraph->getWidth();
+    path.startNewSubPath(xPos, shapeGraph->getTopBound());
+    path.lineTo(xPos, shapeGraph->getBottomBound());
     g.strokePath(path, juce::PathStrokeType(2.0f));
     path.closeSubPath();
 }
 
+void RectanglesAudioProcessorEditor::paintWaveformHistory(juce::Graphics& g, const WaveformHistory& history, juce::Colour colour)   {
+    ///every column is drawn at the phase its audio was played at, so the waveform lines up with the curve
+    ///one min/max query per column and cycle, independent of how many samples a column covers
+    const double cyclesPerSecond = audioProcessor.getCyclesPerSecond();
+    if(cyclesPerSecond <= 0.0 || audioProcessor.getSampleRate() <= 0.0)
+        return;
+    
+    const double samplesPerCycle = audioProcessor.getSampleRate() / cyclesPerSecond;
+    const int width = shapeGraph->getWidth();
+    if(width <= 0)
+        return;
+    
+    const double samplesPerColumn = juce::jmax(1.0, samplesPerCycle / width);
+    const float top = shapeGraph->getTopBound();
+    const float bottom = shapeGraph->getBottomBound();
+    const float centre = (top + bottom) * 0.5f;
+    const float halfHeight = (bottom - top) * 0.5f;
+    const double phaseNow = audioProcessor.getPhase();
+    const juce::int64 newest = history.getNumSamples();
+    
+    for(int cycle = historyCycles - 1; cycle >= 0; --cycle) {
+        //older cycles fade out
+        g.setColour(colour.withAlpha(0.35f / (cycle + 1)));
+        for(int x = 0; x < width; ++x) {
+            double age = phaseNow - (double) x / width;
+            if(age < 0.0)
+                age += 1.0;
+            age = (age + cycle) * samplesPerCycle;
+            
+            const juce::int64 start = newest - (juce::int64) age;
+            const juce::int64 end = start + (juce::int64) samplesPerColumn;
+            float minValue, maxValue;
+            if(history.getMinMax(start, end, minValue, maxValue)) {
+                float y1 = centre - juce::jlimit(-1.0f, 1.0f, maxValue) * halfHeight;
+                float y2 = centre - juce::jlimit(-1.0f, 1.0f, minValue) * halfHeight;
+                g.drawVerticalLine(shapeGraph->getLeftBound() + x, y1, y2 + 1.0f);
+            }
+        }
+    }
+}
+
 void RectanglesAudioProcessorEditor::resized()
 {
     int xMargin = 10;
-    int yMargin = 10;
-    shapeGraph.setHeight(getHeight()-100);
-    shapeGraph.setWidth(getWidth()-xMargin*2);
-    shapeGraph.setLeftBound(xMargin);
-    shapeGraph.setRightBound(shapeGraph.getLeftBound()+shapeGraph.getWidth());
-    shapeGraph.setTopBound(yMargin);
-    shapeGraph.setBottomBound(shapeGraph.getTopBound()+shapeGraph.getHeight());
-    
-    shapeGraph.resizeNodeLayout();
+    for(auto& graph : bandShapeGraphs) {
+        layoutShapeGraph(graph);
+        graph.resizeNodeLayout();
+    }
     
     int itemMargin = 80;
     int buttonSize = 30;
@@ -196,36 +406,72 @@ void RectanglesAudioProcessorEditor::resized()
     panOffsetSlider.setBounds(lfoRateSlider.getX()-itemMargin, getHeight()-40, itemMargin, buttonSize);
     
     scButton.setBounds(xMargin, getHeight()-70, 100, buttonSize);
+    drawButton.setBounds(xMargin, getHeight()-40, 100, buttonSize);
+    importButton.setBounds(drawButton.getRight()+10, getHeight()-40, itemMargin, buttonSize-5);
+    noteTrackButton.setBounds(importButton.getRight()+5, getHeight()-40, itemMargin, buttonSize);
+    modeBox.setBounds(noteTrackButton.getRight()+10, getHeight()-70, itemMargin+5, buttonSize-5);
+    oversamplingBox.setBounds(noteTrackButton.getRight()+10, getHeight()-40, itemMargin+5, buttonSize-5);
     scThresholdSlider.setBounds(scButton.getX()+scButton.getWidth()+itemMargin/2+scThresholdLabel.getWidth(), getHeight()-70, itemMargin, buttonSize);
+    scrubRangeSlider.setBounds(scThresholdSlider.getBounds());
+    transientSensitivitySlider.setBounds(scThresholdSlider.getBounds());
+    scTriggerBox.setBounds(getWidth()-itemMargin-5, getHeight()-170, itemMargin, buttonSize-5);
+    scModeBox.setBounds(getWidth()-itemMargin-5, getHeight()-110, itemMargin, buttonSize-5);
+    
+    //sidechain, filter and band rows between the graph and the other controls
+    scFilterBox.setBounds(xMargin, getHeight()-170, itemMargin+5, buttonSize-5);
+    scFilterFreqSlider.setBounds(scFilterBox.getRight()+50, getHeight()-172, itemMargin, buttonSize);
+    scAuditionButton.setBounds(scFilterFreqSlider.getRight()+10, getHeight()-172, itemMargin, buttonSize);
+    destinationBox.setBounds(xMargin, getHeight()-140, itemMargin-10, buttonSize-5);
+    filterTypeBox.setBounds(destinationBox.getRight()+10, getHeight()-140, itemMargin+5, buttonSize-5);
+    cutoffSlider.setBounds(filterTypeBox.getRight()+60, getHeight()-142, itemMargin, buttonSize);
+    filterRangeSlider.setBounds(cutoffSlider.getRight()+60, getHeight()-142, itemMargin, buttonSize);
+    resonanceSlider.setBounds(filterRangeSlider.getRight()+50, getHeight()-142, itemMargin, buttonSize);
+    ccOutputButton.setBounds(getWidth()-itemMargin-5, getHeight()-142, itemMargin, buttonSize);
+    bandsBox.setBounds(xMargin, getHeight()-110, itemMargin-10, buttonSize-5);
+    bandSelector.setBounds(bandsBox.getRight()+10, getHeight()-110, itemMargin+5, buttonSize-5);
+    bandDepthSlider.setBounds(bandSelector.getRight()+60, getHeight()-112, itemMargin, buttonSize);
+    bandPhaseSlider.setBounds(bandDepthSlider.getRight()+60, getHeight()-112, itemMargin, buttonSize);
+    crossoverSlider.setBounds(bandPhaseSlider.getRight()+50, getHeight()-112, itemMargin, buttonSize);
+    //in the header row above the graph, right aligned with it
+    loadMeterButton.setBounds(getWidth()-xMargin-200, 6, 200, 16);
     //scReleaseSlider.setBounds(scButton.getX()+scButton.getWidth()+itemMargin/2+scReleaseLabel.getWidth(), getHeight()-40, itemMargin, buttonSize);
     //scWarningLabel.setBounds(scButton.getX(), getHeight()-40, itemMargin, 30);
     
     repaint();
-    
-    audioProcessor.updateLfoData(shapeGraph);
 }
 
 void RectanglesAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)   {
     //std::cout << "Mouse down" << std::endl;
-    shapeGraph.clearSelection();
-    auto [nodeIndex, node] = shapeGraph.containsPointOnNode(event.getPosition().toFloat());
-    auto [edgeIndex, edge] = shapeGraph.containsPointOnEdge(event.getPosition().toFloat());
+    shapeGraph->clearSelection();
+    if(drawButton.getToggleState()) {
+        freehandStroke.setControlRange(getControlRange());
+        freehandStroke.begin(clampToGraph(event.getPosition().toFloat()));
+        return;
+    }
+    auto [nodeIndex, node] = shapeGraph->containsPointOnNode(event.getPosition().toFloat());
+    auto [edgeIndex, edge] = shapeGraph->containsPointOnEdge(event.getPosition().toFloat());
+    
+    //right click on an edge handle picks its segment type
+    if(edge && event.mods.isPopupMenu()) {
+        showEdgeTypeMenu(edgeIndex);
+        return;
+    }
     
     if(node) {
         //mouse click is on a node
-        shapeGraph.selectNode(nodeIndex);
+        shapeGraph->selectNode(nodeIndex);
         draggedShapeOffset = event.getPosition().toFloat() - node->getPosition();
         
         //quantize if control key is down
         if(event.mods.isCtrlDown()) {
-            shapeGraph.quantizeNode();
+            shapeGraph->quantizeNode();
         }
     }
     if(edge)    {
-        shapeGraph.selectEdge(edgeIndex);
+        shapeGraph->selectEdge(edgeIndex);
         draggedShapeOffset = event.getPosition().toFloat() - edge->getPosition();
         if(event.mods.isCtrlDown()) {
-            shapeGraph.resetEdgeCurve(edgeIndex);
+            shapeGraph->resetEdgeCurve(edgeIndex);
         }
     }
     
@@ -234,44 +480,221 @@ void RectanglesAudioProcessorEditor::mouseDown(const juce::MouseEvent& event)
 
 void RectanglesAudioProcessorEditor::mouseDrag(const juce::MouseEvent& event)   {
     //std::cout << "Mouse drag" << std::endl;
-    mouseDragPending = false;
-    if(shapeGraph.selectionType == ShapeGraph::SelectionType::Node) {
-        shapeGraph.moveNode(event.getPosition().toFloat()-draggedShapeOffset);
+    if(freehandStroke.isActive()) {
+        freehandStroke.addPoint(clampToGraph(event.getPosition().toFloat()));
+        repaint();
+        return;
+    }
+    
+    if(shapeGraph->selectionType == ShapeGraph::SelectionType::Node) {
+        shapeGraph->moveNode(event.getPosition().toFloat()-draggedShapeOffset);
         if(quantizeButton.getToggleState()) {
-            shapeGraph.quantizeNode();
+            shapeGraph->quantizeNode();
         }
-        mouseDragPending = true;
+        submitShape();
     }
     
-    else if(shapeGraph.selectionType == ShapeGraph::SelectionType::Edge) {
-        shapeGraph.moveEdge(event.getPosition().toFloat()-draggedShapeOffset);
-        mouseDragPending = true;
+    else if(shapeGraph->selectionType == ShapeGraph::SelectionType::Edge) {
+        shapeGraph->moveEdge(event.getPosition().toFloat()-draggedShapeOffset);
+        submitShape();
     }
 }
 
 void RectanglesAudioProcessorEditor::mouseDoubleClick(const juce::MouseEvent& event)    {
     //std::cout << "Mouse double click" << std::endl;
-    auto [nodeIndex, node] = shapeGraph.containsPointOnNode(event.getPosition().toFloat());
+    if(drawButton.getToggleState())
+        return;
+    
+    auto [nodeIndex, node] = shapeGraph->containsPointOnNode(event.getPosition().toFloat());
     
     //check wether double click was on node and delete, otherwise create new node
     if(node)    {
-        shapeGraph.removeNode(nodeIndex);
+        shapeGraph->removeNode(nodeIndex);
         std::cout << "Removed node" << std::endl;
     }
     else    {
-        shapeGraph.addNode(event.getPosition().toFloat(), false);
+        shapeGraph->addNode(event.getPosition().toFloat(), false);
         //quantize newly created node
         if(quantizeButton.getToggleState()) {
-            shapeGraph.quantizeNode();
+            shapeGraph->quantizeNode();
         }
         std::cout << "Added node" << std::endl;
     }
-    audioProcessor.updateLfoData(shapeGraph);
+    publishShape();
+    shapeHistory->push(*shapeGraph);
     //repaint();
 }
 
 void RectanglesAudioProcessorEditor::mouseUp(const juce::MouseEvent& event) {
-    shapeGraph.clearSelection();
+    shapeGraph->clearSelection();
+    if(freehandStroke.isActive()) {
+        applyFreehandStroke();
+        repaint();
+    }
+    //a finished drag is one undo step
+    shapeHistory->push(*shapeGraph);
+}
+
+bool RectanglesAudioProcessorEditor::keyPressed(const juce::KeyPress& key) {
+    const bool command = key.getModifiers().isCommandDown();
+    const bool shift = key.getModifiers().isShiftDown();
+    
+    if(command && key.getKeyCode() == 'Z') {
+        bool changed = shift ? shapeHistory->redo(*shapeGraph) : shapeHistory->undo(*shapeGraph);
+        if(changed) {
+            //recent shapes are still cached in the compiler, so this republishes without recompiling
+            publishShape();
+            repaint();
+        }
+        return true;
+    }
+    if(command && key.getKeyCode() == 'Y') {
+        if(shapeHistory->redo(*shapeGraph)) {
+            publishShape();
+            repaint();
+        }
+        return true;
+    }
+    return false;
+}
+
+void RectanglesAudioProcessorEditor::applyFreehandStroke() {
+    ///replace the part of the shape under the stroke with its simplified segments
+    freehandStroke.finish();
+    const auto& segments = freehandStroke.getSegments();
+    if(!segments.empty()) {
+        std::vector<juce::Point<float>> nodeCentres;
+        std::vector<float> controlYs;
+        nodeCentres.push_back(segments.front().start);
+        for(const auto& segment : segments) {
+            nodeCentres.push_back(segment.end);
+            controlYs.push_back(segment.controlY);
+        }
+        shapeGraph->insertCurve(nodeCentres, controlYs);
+        publishShape();
+    }
+    freehandStroke.clear();
+}
+
+void RectanglesAudioProcessorEditor::showEdgeTypeMenu(int edgeIndex) {
+    juce::PopupMenu menu;
+    for(int type = 0; type < SegmentShapes::numTypes; ++type) {
+        auto segmentType = (SegmentType) type;
+        menu.addItem(type + 1, SegmentShapes::getName(segmentType), true, shapeGraph->edges[edgeIndex]->type == segmentType);
+    }
+    
+    juce::Component::SafePointer<RectanglesAudioProcessorEditor> safeThis(this);
+    menu.showMenuAsync(juce::PopupMenu::Options(), [safeThis, edgeIndex](int result) {
+        if(safeThis == nullptr || result == 0 || edgeIndex >= safeThis->shapeGraph->edges.size())
+            return;
+        safeThis->shapeGraph->setEdgeType(edgeIndex, (SegmentType) (result - 1));
+        safeThis->publishShape();
+        safeThis->shapeHistory->push(*safeThis->shapeGraph);
+        safeThis->repaint();
+    });
+}
+
+void RectanglesAudioProcessorEditor::importButtonClicked() {
+    fileChooser = std::make_unique<juce::FileChooser>("Import shape from audio", juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+    
+    fileChooser->launchAsync(flags, [this](const juce::FileChooser& chooser) {
+        auto file = chooser.getResult();
+        if(!file.existsAsFile())
+            return;
+        
+        //one 4/4 bar at the host tempo, every bar of the file is folded onto it
+        double barSeconds = 4.0 * 60.0 / audioProcessor.getBpm();
+        //the shape belongs to the band that was edited when the import started
+        juce::Component::SafePointer<RectanglesAudioProcessorEditor> safeThis(this);
+        const int band = editedBand;
+        envelopeImporter.start(file, barSeconds, [safeThis, band](std::vector<float> envelope) {
+            if(safeThis != nullptr && safeThis->editedBand == band)
+                safeThis->applyEnvelope(envelope);
+        });
+    });
+}
+
+void RectanglesAudioProcessorEditor::loadMeterButtonClicked() {
+    juce::PopupMenu menu;
+    menu.addItem(1, "Reset");
+    menu.addItem(2, "Save to file...");
+    
+    juce::Component::SafePointer<RectanglesAudioProcessorEditor> safeThis(this);
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&loadMeterButton), [safeThis](int result) {
+        if(safeThis == nullptr)
+            return;
+        if(result == 1) {
+            safeThis->audioProcessor.loadMeter.reset();
+        } else if(result == 2) {
+            safeThis->fileChooser = std::make_unique<juce::FileChooser>("Save DSP load", juce::File(), "*.json");
+            auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting;
+            safeThis->fileChooser->launchAsync(flags, [safeThis](const juce::FileChooser& chooser) {
+                auto file = chooser.getResult();
+                if(safeThis == nullptr || file == juce::File())
+                    return;
+                auto saved = safeThis->audioProcessor.loadMeter.dumpToFile(file.withFileExtension("json"));
+                if(saved.failed())
+                    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Save DSP load", saved.getErrorMessage());
+            });
+        }
+    });
+}
+
+void RectanglesAudioProcessorEditor::updateLoadMeter() {
+    ///share of the block's real-time budget, mean and p99 since the last reset and the worst block
+    const auto statistics = audioProcessor.loadMeter.getStatistics();
+    if(statistics.numBlocks == 0) {
+        loadMeterButton.setButtonText("DSP -");
+        return;
+    }
+    loadMeterButton.setButtonText("DSP " + juce::String(statistics.meanPercent, 1) + "%  p99 "
+                                  + juce::String(statistics.p99Percent, 1) + "%  max "
+                                  + juce::String(statistics.maxPercent, 1) + "%");
+}
+
+void RectanglesAudioProcessorEditor::applyEnvelope(const std::vector<float>& envelope) {
+    ///turn the envelope into a shape, the tolerance grows until the node count fits
+    if(envelope.size() < 2)
+        return;
+    
+    std::vector<juce::Point<float>> points;
+    const float top = shapeGraph->getTopBound() + shapeGraph->getNodeSize()/2;
+    const float bottom = shapeGraph->getBottomBound() - shapeGraph->getNodeSize()/2;
+    for(size_t i = 0; i < envelope.size(); ++i) {
+        float x = shapeGraph->getLeftBound() + (float) i / (envelope.size()-1) * shapeGraph->getWidth();
+        float y = bottom - envelope[i] * (bottom - top);
+        points.push_back({ x, y });
+    }
+    
+    float tolerance = 1.0f;
+    auto segments = FreehandStroke::simplify(points, tolerance, getControlRange());
+    while((int) segments.size() + 1 > maxImportedNodes) {
+        tolerance *= 1.5f;
+        segments = FreehandStroke::simplify(points, tolerance, getControlRange());
+    }
+    
+    std::vector<juce::Point<float>> nodeCentres { segments.front().start };
+    std::vector<float> controlYs;
+    for(const auto& segment : segments) {
+        nodeCentres.push_back(segment.end);
+        controlYs.push_back(segment.controlY);
+    }
+    shapeGraph->insertCurve(nodeCentres, controlYs);
+    publishShape();
+    shapeHistory->push(*shapeGraph);
+    repaint();
+}
+
+juce::Point<float> RectanglesAudioProcessorEditor::clampToGraph(juce::Point<float> point) {
+    float x = juce::jlimit((float) shapeGraph->getLeftBound(), (float) shapeGraph->getRightBound(), point.getX());
+    float y = getControlRange().clipValue(point.getY());
+    return { x, y };
+}
+
+juce::Range<float> RectanglesAudioProcessorEditor::getControlRange() {
+    ///the centre y range of nodes and edge handles, ShapeGraph::updateEdge clamps handles to it
+    return { (float) shapeGraph->getTopBound() + shapeGraph->getNodeSize()/2, (float) shapeGraph->getBottomBound() - shapeGraph->getNodeSize()/2 };
 }
 
 void RectanglesAudioProcessorEditor::lfoRateSliderValueChanged() {
@@ -279,7 +702,7 @@ void RectanglesAudioProcessorEditor::lfoRateSliderValueChanged() {
         int index = (int) lfoRateSlider.getValue();
         float value = rhythmValues[index];
         audioProcessor.setLfoRate(value);
-        *audioProcessor.parameters.getRawParameterValue("lfoRate") = value; // <-- this ensures persistence
+        *audioProcessor.parameters.getRawParameterValue("lfo rate") = value; // <-- this ensures persistence
         lastSyncedValue = index;
     }
     else    {
@@ -298,7 +721,7 @@ void RectanglesAudioProcessorEditor::syncButtonClicked()    {
 
 void RectanglesAudioProcessorEditor::enableFreeMode()
 {
-    lfoRateSlider.setRange(0.01, 20.0, 0.01);
+    lfoRateSlider.setRange(0.01, 2000.0, 0.01);
     lfoRateSlider.setSkewFactorFromMidPoint(4.0f);
     audioProcessor.setLfoRate(lfoRateSlider.getValue());
     if(lastFreeValue > 0.0f)  {
@@ -331,34 +754,141 @@ void RectanglesAudioProcessorEditor::enableSyncMode()   {
         return rhythmLabels.indexOf(text);
     };
     audioProcessor.setLfoRate(rhythmValues[(int) lfoRateSlider.getValue()]);
-    *audioProcessor.parameters.getRawParameterValue("lfoRate") = rhythmValues[(int) lfoRateSlider.getValue()];
+    *audioProcessor.parameters.getRawParameterValue("lfo rate") = rhythmValues[(int) lfoRateSlider.getValue()];
 }
 
 
 
 void RectanglesAudioProcessorEditor::scButtonClicked() {
     bool scActivated = scButton.getToggleState();
-    scThresholdSlider.setVisible(scActivated);
+    const bool scrub = scModeBox.getSelectedItemIndex() == 1;
+    const bool transient = scTriggerBox.getSelectedItemIndex() == 1;
+    scThresholdSlider.setVisible(scActivated && !scrub && !transient);
+    transientSensitivitySlider.setVisible(scActivated && !scrub && transient);
+    scTriggerBox.setVisible(scActivated && !scrub);
+    scrubRangeSlider.setVisible(scActivated && scrub);
+    scModeBox.setVisible(scActivated);
+    scFilterBox.setVisible(scActivated);
+    scFilterFreqSlider.setVisible(scActivated);
+    scAuditionButton.setVisible(scActivated);
     //scReleaseSlider.setVisible(scActivated);
     /*if(scActivated) {
-        scWarningLabel.setVisible(audioProcessor.showWarningLabel);
+        scWarningLabel.setVisible(audioProcessor.shouldShowWarningLabel());
     }*/
     audioProcessor.setScActivated(scActivated);
 }
 
 
-void RectanglesAudioProcessorEditor::timerCallback() {
-    if(mouseDragPending) {
-        audioProcessor.updateLfoData(shapeGraph);
-        mouseDragPending = false;
+void RectanglesAudioProcessorEditor::publishShape() {
+    ///hand the current shape to the processor, both as modulation values and as state for saving
+    submitShape();
+    storeShapeState();
+}
+
+void RectanglesAudioProcessorEditor::publishPendingShape() {
+    ///publishes an edit that isn't published yet, a drag has already submitted its segments so only the state is left then
+    if (shapeGraph->getVersion() == publishedShapeVersion)
+        return;
+    if (shapeGraph->getVersion() == submittedShapeVersion)
+        storeShapeState();
+    else
+        publishShape();
+}
+
+void RectanglesAudioProcessorEditor::storeShapeState() {
+    if (auto xml = shapeGraph->createXML())
+        audioProcessor.setShapeGraphXmlString(xml->toString(), editedBand);
+    publishedShapeVersion = shapeGraph->getVersion();
+}
+
+void RectanglesAudioProcessorEditor::submitShape() {
+    ///only the modulation values, cheap enough for every mouse event of a drag
+    audioProcessor.updateLfoData(*shapeGraph, editedBand);
+    submittedShapeVersion = shapeGraph->getVersion();
+}
+
+void RectanglesAudioProcessorEditor::layoutShapeGraph(ShapeGraph& graph) {
+    int xMargin = 10;
+    int yMargin = 10;
+    int headerHeight = 20;      //the load meter sits above the graph
+    graph.setHeight(getHeight()-190-headerHeight);
+    graph.setWidth(getWidth()-xMargin*2);
+    graph.setLeftBound(xMargin);
+    graph.setRightBound(graph.getLeftBound()+graph.getWidth());
+    graph.setTopBound(yMargin+headerHeight);
+    graph.setBottomBound(graph.getTopBound()+graph.getHeight());
+}
+
+void RectanglesAudioProcessorEditor::selectBand(int band) {
+    ///switch the graph, history and band sliders over to another band
+    band = juce::jlimit(0, RectanglesAudioProcessor::maxBands - 1, band);
+    publishPendingShape();
+    shapeGraph->clearSelection();
+    freehandStroke.clear();
+    
+    editedBand = band;
+    shapeGraph = &bandShapeGraphs[band];
+    shapeHistory = &bandShapeHistories[band];
+    publishedShapeVersion = shapeGraph->getVersion();
+    submittedShapeVersion = publishedShapeVersion;
+    bandSelector.setSelectedId(band + 1, juce::dontSendNotification);
+    
+    //attachments are recreated so the sliders follow the band's parameters
+    const juce::String prefix = "band" + juce::String(band + 1);
+    bandDepthSliderAttachment.reset();
+    bandPhaseSliderAttachment.reset();
+    crossoverSliderAttachment.reset();
+    bandDepthSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, prefix + " depth", bandDepthSlider);
+    bandPhaseSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, prefix + " phase", bandPhaseSlider);
+    if(band < RectanglesAudioProcessor::maxBands - 1)
+        crossoverSliderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.parameters, "crossover " + juce::String(band + 1), crossoverSlider);
+    
+    updateBandControls();
+    repaint();
+}
+
+void RectanglesAudioProcessorEditor::updateBandControls() {
+    ///band controls only show up with more than one band, the highest band has no split above it
+    const int numBands = bandsBox.getSelectedItemIndex() + 1;
+    if(editedBand >= numBands) {
+        selectBand(0);
+        return;
     }
-    if (auto xml = shapeGraph.createXML())
-        audioProcessor.setShapeGraphXmlString(xml->toString());
+    
+    const bool multiband = numBands > 1;
+    for(int band = 0; band < RectanglesAudioProcessor::maxBands; ++band)
+        bandSelector.setItemEnabled(band + 1, band < numBands);
+    bandSelector.setVisible(multiband);
+    bandDepthSlider.setVisible(multiband);
+    bandPhaseSlider.setVisible(multiband);
+    crossoverSlider.setVisible(multiband && editedBand < numBands - 1);
+}
+
+void RectanglesAudioProcessorEditor::updateFilterControls() {
+    const bool filterDestination = destinationBox.getSelectedItemIndex() == 1;
+    filterTypeBox.setVisible(filterDestination);
+    cutoffSlider.setVisible(filterDestination);
+    filterRangeSlider.setVisible(filterDestination);
+    resonanceSlider.setVisible(filterDestination);
+}
+
+void RectanglesAudioProcessorEditor::timerCallback() {
+    LFOTOOL_TRACE_THREAD("Message")
+    LFOTOOL_TRACE_SCOPE("timerCallback")
+    audioProcessor.inputHistory.pull();
+    audioProcessor.outputHistory.pull();
+    
+    //only regenerate and serialize when the shape was actually edited
+    publishPendingShape();
     
     bpm = audioProcessor.getBpm();
     
+   #if LFOTOOL_LOAD_METER
+    updateLoadMeter();
+   #endif
+    
     /*if(scButton.getToggleState()) {
-        scWarningLabel.setVisible(audioProcessor.showWarningLabel);
+        scWarningLabel.setVisible(audioProcessor.shouldShowWarningLabel());
     }*/
     repaint();
 }
@@ -11,6 +11,9 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "ShapeGraph.h"
+#include "ShapeHistory.h"
+#include "FreehandStroke.h"
+#include "EnvelopeImporter.h"
 
 //==============================================================================
 /**
@@ -29,6 +32,7 @@ public:
     void mouseDrag(const juce::MouseEvent&) override;
     void mouseDoubleClick(const juce::MouseEvent&) override;
     void mouseUp(const juce::MouseEvent&) override;
+    bool keyPressed(const juce::KeyPress&) override;
     
     void syncButtonClicked();
 
@@ -37,7 +41,16 @@ private:
     RectanglesAudioProcessor& audioProcessor;
     int paintCounter = 0;
     
-    ShapeGraph shapeGraph;
+    //one shape and undo history per band, shapeGraph and shapeHistory point at the band being edited
+    std::array<ShapeGraph, RectanglesAudioProcessor::maxBands> bandShapeGraphs;
+    std::array<ShapeHistory, RectanglesAudioProcessor::maxBands> bandShapeHistories;
+    ShapeGraph* shapeGraph = &bandShapeGraphs[0];
+    ShapeHistory* shapeHistory = &bandShapeHistories[0];
+    int editedBand = 0;
+    FreehandStroke freehandStroke;
+    EnvelopeImporter envelopeImporter;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    const int maxImportedNodes = 32;
     juce::Point<float> draggedShapeOffset;
     
     juce::Slider lfoRateSlider;
@@ -50,6 +63,39 @@ private:
     juce::Slider scThresholdSlider;
     juce::Label scThresholdLabel;
     juce::ToggleButton scButton;
+    juce::ToggleButton drawButton;
+    juce::TextButton importButton;
+    juce::TextButton loadMeterButton;
+    juce::ComboBox modeBox;
+    juce::ComboBox oversamplingBox;
+    juce::ToggleButton noteTrackButton;
+    juce::ComboBox bandsBox;
+    juce::ComboBox bandSelector;
+    juce::Slider bandDepthSlider;
+    juce::Label bandDepthLabel;
+    juce::Slider bandPhaseSlider;
+    juce::Label bandPhaseLabel;
+    juce::Slider crossoverSlider;
+    juce::Label crossoverLabel;
+    juce::ComboBox destinationBox;
+    juce::ComboBox filterTypeBox;
+    juce::Slider cutoffSlider;
+    juce::Label cutoffLabel;
+    juce::Slider filterRangeSlider;
+    juce::Label filterRangeLabel;
+    juce::Slider resonanceSlider;
+    juce::Label resonanceLabel;
+    juce::ToggleButton ccOutputButton;
+    juce::ComboBox scModeBox;
+    juce::Slider scrubRangeSlider;
+    juce::Label scrubRangeLabel;
+    juce::ComboBox scFilterBox;
+    juce::Slider scFilterFreqSlider;
+    juce::Label scFilterFreqLabel;
+    juce::ToggleButton scAuditionButton;
+    juce::ComboBox scTriggerBox;
+    juce::Slider transientSensitivitySlider;
+    juce::Label transientSensitivityLabel;
     //juce::Slider scReleaseSlider;
     //juce::Label scReleaseLabel;
     //juce::Label scWarningLabel;
@@ -61,6 +107,26 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> scReleaseSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> panOffsetSliderAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> quantizeButtonAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> modeBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> noteTrackButtonAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> bandsBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandDepthSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bandPhaseSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> crossoverSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> destinationBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> filterTypeBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> cutoffSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> filterRangeSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> resonanceSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> ccOutputButtonAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> scModeBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> scrubRangeSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> scFilterBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> scFilterFreqSliderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> scAuditionButtonAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> scTriggerBoxAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> transientSensitivitySliderAttachment;
     
     
     std::vector<float> rhythmValues {
@@ -85,16 +151,37 @@ private:
     float bpm = 120.0f;
     
     bool lfoChangePending = false;
-    bool mouseDragPending = false;
+    juce::uint32 publishedShapeVersion = 0;
+    juce::uint32 submittedShapeVersion = 0;     //last version whose segments went to the compiler, drags submit ahead of the timer
     bool sideChainActive = false;
     float lastSyncedValue = 0.0f;
     float lastFreeValue = 0.0f;
     
+    //number of past cycles drawn behind the shape
+    const int historyCycles = 3;
+    
     void noiseButtonClicked();
     void lfoRateSliderValueChanged();
     void scButtonClicked();
     void enableSyncMode();
     void enableFreeMode();
+    void publishShape();
+    void publishPendingShape();
+    void submitShape();
+    void storeShapeState();
+    void selectBand(int band);
+    void updateBandControls();
+    void updateFilterControls();
+    void layoutShapeGraph(ShapeGraph& graph);
+    void applyFreehandStroke();
+    void importButtonClicked();
+    void loadMeterButtonClicked();
+    void updateLoadMeter();
+    void showEdgeTypeMenu(int edgeIndex);
+    void applyEnvelope(const std::vector<float>& envelope);
+    juce::Point<float> clampToGraph(juce::Point<float> point);
+    juce::Range<float> getControlRange();
+    void paintWaveformHistory(juce::Graphics& g, const WaveformHistory& history, juce::Colour colour);
     
     void timerCallback() override;
     
@@ -9,6 +9,8 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "Modulator.h"
+#include "RealtimeGuard.h"
+#include "TraceRecorder.h"
 #include <optional>
 #include <juce_data_structures/juce_data_structures.h>
 
@@ -18,14 +20,20 @@ RectanglesAudioProcessor::RectanglesAudioProcessor()
 :  AudioProcessor (BusesProperties()
                    .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                    .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                   .withOutput ("CV Out", juce::AudioChannelSet::mono(), false)
                    .withInput  ("Aux Input", juce::AudioChannelSet::stereo(), true)
                    ),
 parameters (*this, nullptr, "PARAMETERS", [] {
     using namespace juce;
     AudioProcessorValueTreeState::ParameterLayout layout;
     
+    //goes up into the audio range for tremolo/AM, fast rates are read from band-limited tables
+    //replaces "lfoRate" (0.01-20Hz linear) under a new id, so host automation recorded against the old
+    //normalised range isn't remapped, saved states are converted in setStateInformation
+    NormalisableRange<float> lfoRateRange(0.01f, 2000.0f, 0.01f);
+    lfoRateRange.setSkewForCentre(4.0f);
     layout.add(std::make_unique<AudioParameterFloat>(
-                                                     ParameterID{"lfoRate", 1}, "LFO Rate", NormalisableRange<float>(0.01f, 20.0f, 0.01f), 1.0f));
+                                                     ParameterID{"lfo rate", 2}, "LFO Rate", lfoRateRange, 1.0f));
     
     layout.add(std::make_unique<AudioParameterBool>(
                                                     ParameterID{"sync", 1}, "Sync", false));
@@ -42,15 +50,91 @@ parameters (*this, nullptr, "PARAMETERS", [] {
                                                      ParameterID{"sc release", 1}, "SC Release", NormalisableRange<float>(0.01f, 1.0f), 0.01f));
     layout.add(std::make_unique<AudioParameterBool>(
                                                      ParameterID{"sc", 1}, "SC", false));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"sc mode", 1}, "SC Mode", StringArray{"Trigger", "Scrub"}, 0));
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"scrub range", 1}, "Scrub Range", NormalisableRange<float>(0.0f, 1.0f), 1.0f));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"sc trigger", 1}, "SC Trigger", StringArray{"Level", "Transient"}, 0));
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"transient sensitivity", 1}, "Transient Sensitivity", NormalisableRange<float>(0.0f, 1.0f), 0.5f));
+    //off keeps the per block detection existing sessions were made with
+    layout.add(std::make_unique<AudioParameterBool>(
+                                                    ParameterID{"deterministic", 1}, "Deterministic", false));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"sc filter", 1}, "SC Filter", StringArray{"Off", "Highpass", "Lowpass", "Bandpass"}, 0));
+    NormalisableRange<float> scFilterRange(20.0f, 20000.0f, 1.0f);
+    scFilterRange.setSkewForCentre(1000.0f);
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"sc filter freq", 1}, "SC Filter Freq", scFilterRange, 150.0f));
+    layout.add(std::make_unique<AudioParameterBool>(
+                                                    ParameterID{"sc audition", 1}, "SC Audition", false));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"mode", 1}, "Mode", StringArray{"LFO", "AM", "Ring", "Shaper"}, 0));
+    layout.add(std::make_unique<AudioParameterBool>(
+                                                     ParameterID{"note track", 1}, "Note Track", false));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"oversampling", 1}, "Oversampling", StringArray{"1x", "2x", "4x", "8x"}, 2));
+    
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"bands", 1}, "Bands", StringArray{"1", "2", "3", "4"}, 0));
+    NormalisableRange<float> crossoverRange(20.0f, 20000.0f, 1.0f);
+    crossoverRange.setSkewForCentre(1000.0f);
+    const float crossoverDefaults[] = { 120.0f, 1000.0f, 5000.0f };
+    for (int split = 1; split < RectanglesAudioProcessor::maxBands; ++split)
+        layout.add(std::make_unique<AudioParameterFloat>(
+                                                         ParameterID{"crossover " + String(split), 1}, "Crossover " + String(split), crossoverRange, crossoverDefaults[split - 1]));
+    
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"destination", 1}, "Destination", StringArray{"Gain", "Filter"}, 0));
+    layout.add(std::make_unique<AudioParameterChoice>(
+                                                     ParameterID{"filter type", 1}, "Filter Type", StringArray{"Lowpass", "Bandpass", "Highpass"}, 0));
+    NormalisableRange<float> cutoffRange(ModulatedFilter::minFrequency, ModulatedFilter::maxFrequency, 1.0f);
+    cutoffRange.setSkewForCentre(1000.0f);
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"cutoff", 1}, "Cutoff", cutoffRange, 300.0f));
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"filter range", 1}, "Filter Range", NormalisableRange<float>(0.0f, 8.0f), 4.0f));
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"resonance", 1}, "Resonance", NormalisableRange<float>(0.5f, ModulatedFilter::maxResonance, 0.0f, 0.5f), 0.707f));
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"resonance mod", 1}, "Resonance Mod", NormalisableRange<float>(0.0f, 1.0f), 0.0f));
+    
+    layout.add(std::make_unique<AudioParameterBool>(
+                                                    ParameterID{"cc output", 1}, "CC Output", false));
+    layout.add(std::make_unique<AudioParameterInt>(
+                                                   ParameterID{"cc number", 1}, "CC Number", 0, 119, 1));
+    NormalisableRange<float> ccRateRange(10.0f, 1000.0f, 1.0f);
+    ccRateRange.setSkewForCentre(100.0f);
+    layout.add(std::make_unique<AudioParameterFloat>(
+                                                     ParameterID{"cc rate", 1}, "CC Rate", ccRateRange, 100.0f));
+    
+    for (int band = 1; band <= RectanglesAudioProcessor::maxBands; ++band) {
+        layout.add(std::make_unique<AudioParameterFloat>(
+                                                         ParameterID{"band" + String(band) + " depth", 1}, "Band " + String(band) + " Depth", NormalisableRange<float>(0.0f, 1.0f), 1.0f));
+        layout.add(std::make_unique<AudioParameterFloat>(
+                                                         ParameterID{"band" + String(band) + " phase", 1}, "Band " + String(band) + " Phase", NormalisableRange<float>(0.0f, 1.0f), 0.0f));
+    }
     
     return layout;
 }())
 #endif
 {
+    //looked up once, building the ids on the audio thread would allocate
+    for (int band = 0; band < maxBands; ++band) {
+        const juce::String prefix = "band" + juce::String(band + 1);
+        bandDepthParameters[band] = parameters.getRawParameterValue(prefix + " depth");
+        bandPhaseParameters[band] = parameters.getRawParameterValue(prefix + " phase");
+    }
+
+   #if LFOTOOL_TRACE
+    TraceRecorder::getInstance().startFromEnvironment();
+   #endif
 }
 
 RectanglesAudioProcessor::~RectanglesAudioProcessor()
 {
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -61,12 +145,15 @@ const juce::String RectanglesAudioProcessor::getName() const
 
 bool RectanglesAudioProcessor::acceptsMidi() const
 {
-    return false;
+    //notes set the oscillator frequency in the audio rate modes, optional: the AU stays an 'aufx' effect so existing
+    //sessions still find it, hosts that don't send MIDI to effects run the oscillator at the rate instead
+    return true;
 }
 
 bool RectanglesAudioProcessor::producesMidi() const
 {
-    return false;
+    //the modulation can be sent out as a CC stream
+    return true;
 }
 
 bool RectanglesAudioProcessor::isMidiEffect() const
@@ -107,8 +194,58 @@ void RectanglesAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
 {
     this->sampleRate = (float) sampleRate;
     phase = 0.0f;
-    lfoSmoothed.resize(getTotalNumInputChannels(), 1.0f);
-    scSmoothed.resize(getTotalNumInputChannels(), 1.0f);
+    lfoTriggered = false;
+    currentNote = -1;
+    syncParameterMembers();
+    loadMeter.prepare(sampleRate);
+    //everything that carries over between blocks starts from the same state, renders of the same input are repeatable
+    lfoSmoothed.assign(juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()), 1.0f);
+    scSmoothed.assign(getTotalNumInputChannels(), 1.0f);
+    lastModulationOutput = 0.0f;
+    blockStartSample = 0;
+    samplesProcessed = 0;
+    //10ms level windows in deterministic mode
+    levelWindowSize = juce::jmax(1, juce::roundToInt(0.01 * sampleRate));
+    levelWindowFill = 0;
+    levelWindowSums.fill(0.0);
+    syncAnchorSample = -1;
+    
+    preparedBlockSize = samplesPerBlock;
+    activeOversampler = -1;
+    for (size_t factor = 0; factor < oversamplers.size(); ++factor)
+    {
+        //polyphase IIR half-band filters with integer latency, so the reported latency is exact
+        oversamplers[factor] = std::make_unique<juce::dsp::Oversampling<float>>(
+            2, factor, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+        oversamplers[factor]->initProcessing((size_t) samplesPerBlock);
+    }
+    modulationBuffer.setSize(2, samplesPerBlock << (oversamplers.size() - 1));
+    modulationOutput.assign((size_t) samplesPerBlock, 0.0f);
+    ccCountdown = 0;
+    lastCcValue = -1;
+    scrubEnvelope = 0.0f;
+    sidechainFilter.prepare(sampleRate);
+    transientDetector.prepare(sampleRate);
+    scFilterBuffer.setSize(2, samplesPerBlock);
+    //not the audio thread, the host can be told right away, so it knows the latency before the first block
+    cancelPendingUpdate();
+    reportedLatency = getLatencyForParameters();
+    pendingLatency.store(reportedLatency, std::memory_order_relaxed);
+    setLatencySamples(reportedLatency);
+    
+    //~10 Hz corner
+    dcCoefficient = 1.0f - juce::MathConstants<float>::twoPi * 10.0f / (float) sampleRate;
+    dcLastInput.fill(0.0f);
+    dcLastOutput.fill(0.0f);
+    
+    //the splits start where the parameters are instead of gliding there
+    crossover.setCrossoverFrequencies(parameters.getRawParameterValue("crossover 1")->load(),
+                                      parameters.getRawParameterValue("crossover 2")->load(),
+                                      parameters.getRawParameterValue("crossover 3")->load());
+    crossover.prepare(sampleRate);
+    filter.prepare(sampleRate, 2);
+    for (auto& smoothed : bandSmoothed)
+        smoothed.fill(1.0f);
 }
 
 void RectanglesAudioProcessor::releaseResources()
@@ -132,12 +269,20 @@ bool RectanglesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
             return false;
     }
     
+    //the CV output is either off or a single channel
+    if(layouts.outputBuses.size() > 1 && layouts.getNumChannels(false, 1) > 1)
+        return false;
+    
     return true;
 }
 #endif
 
 void RectanglesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    LFOTOOL_REALTIME_SCOPE
+    LFOTOOL_LOAD_SCOPE(loadMeter, buffer.getNumSamples())
+    LFOTOOL_TRACE_THREAD("Audio")
+    LFOTOOL_TRACE_SCOPE("processBlock")
 
     for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
@@ -145,113 +290,667 @@ void RectanglesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     updatePositionInfo();
 
     const int numSamples = buffer.getNumSamples();
-    float delta_f = lfoRate / sampleRate;
+    blockStartSample = samplesProcessed;
+    samplesProcessed += numSamples;
     
-    if(scActivated)    {
-        juce::AudioBuffer<float> scBuffer = getBusBuffer(buffer, true, 1);
-        float meanRms = 0.0f;
-        const int numScChannels = scBuffer.getNumChannels();
-        if(numScChannels > 0)    {
-            showWarningLabel = false;
-            for (int channel = 0; channel < scBuffer.getNumChannels(); ++channel)
-                meanRms += scBuffer.getRMSLevel(channel, 0, numSamples);
-            meanRms /= scBuffer.getNumChannels();
-        } else  showWarningLabel = true;
+    //fast rates read band-limited tables, they don't need the smoother and it would eat the modulation
+    const double phaseIncrement = getCyclesPerSecond() / sampleRate;
+    mipLevel = modulator.getMipLevel(phaseIncrement);
+    smoothingCoefficient = juce::jlimit(smoothing, 1.0f, (float) (smoothing * phaseIncrement * modulator.getResolution()));
+    
+    if(buffer.getNumChannels() > 0)
+        inputHistory.push(buffer.getReadPointer(0), numSamples);
+    
+    auto mode = (ModulationMode) (int) parameters.getRawParameterValue("mode")->load();
+    if(mode != ModulationMode::LFO) {
+        processAudioRate(buffer, midiMessages, mode);
+        if(buffer.getNumChannels() > 0)
+            outputHistory.push(buffer.getReadPointer(0), numSamples);
+        writeModulationOutputs(buffer, midiMessages, numSamples);
+        return;
+    }
+    activeOversampler = -1;
+    updateLatency(0);
+    prepareMultibandBlock();
+    prepareFilterBlock();
+    //samples the gain stage skips (sync without a host position) keep the last value
+    std::fill(modulationOutput.begin(), modulationOutput.begin() + juce::jmin(numSamples, (int) modulationOutput.size()), lastModulationOutput);
+    const float currentRate = lfoRate.load(std::memory_order_relaxed);
+    const bool sidechainActivated = scActivated.load(std::memory_order_relaxed);
+    float delta_f = currentRate / sampleRate;
+    
+    sidechainFilter.setParameters((SidechainFilter::Type) (int) parameters.getRawParameterValue("sc filter")->load(),
+                                  parameters.getRawParameterValue("sc filter freq")->load());
+    auto scBuffer = sidechainActivated ? getSidechainBuffer(buffer, numSamples) : juce::AudioBuffer<float>();
+    
+    if(sidechainActivated && parameters.getRawParameterValue("sc mode")->load() > 0.5f)    {
+        processScrubBlock(buffer, scBuffer, numSamples);
+    }
+    else if(sidechainActivated)    {
+        setShowWarningLabel(scBuffer.getNumChannels() == 0);
+        curScRelease = scRelease.load(std::memory_order_relaxed);
         
-        if (meanRms > scThreshold)
-        {
-            lfoTriggered = true;
-            phase = 0.0;
-            //curScRelease = 4.0f * scRelease * (lfoRate / sampleRate);
-            curScRelease = scRelease;
-        }
-        previousRms = meanRms;
+        //synced, a triggered cycle lasts one tempo synced period
+        double triggerIncrement = delta_f;
+        if (parameters.getRawParameterValue("sync")->load() && positionInfo.getPpqPosition())
+            triggerIncrement = getBpm() * currentRate / (60.0 * sampleRate);
         
-        if (lfoTriggered)    {
-            if (parameters.getRawParameterValue("sync")->load())
-            {
-                if (auto ppq = positionInfo.getPpqPosition())
-                {
-                    float secondsPerCycle = 60.0f / (getBpm() * lfoRate);
-                    delta_f = 1.0f / (secondsPerCycle * sampleRate);
-                }
-                
-            }
-            for (int sample = 0; sample < numSamples; ++sample)
-            {
-                processSample(sample, buffer);
-                phase += delta_f;
-                
-                if(phase >= 1.0)
-                {
-                    //do release update here
-                    /*if(curScRelease >= 0.01f)    {
-                        //decrease the release time
-                        curScRelease -= delta_f;
-                    }*/
-                    lfoTriggered = false;
-                    break;
-                }
-            }
+        if (parameters.getRawParameterValue("deterministic")->load() > 0.5f)
+            processDeterministicTriggerBlock(buffer, scBuffer, numSamples, triggerIncrement);
+        else
+            processTriggerBlock(buffer, scBuffer, numSamples, triggerIncrement);
+    }
+    else { //if not sidechaining
+        curScRelease = scRelease.load(std::memory_order_relaxed);
+        if (parameters.getRawParameterValue("sync")->load())    {
+            processSyncBlock(buffer, numSamples);
         }
         else    {
-            //keep the last phase
-            curScRelease = scRelease;
-            phase = modulator.getLastModulationValue();
             for (int sample = 0; sample < numSamples; ++sample) {
                 processSample(sample, buffer);
+                phase = std::fmod(phase + delta_f, 1.0f);
             }
         }
     }
+    
+    //listen to what the detection hears instead of the output
+    if(sidechainActivated && scBuffer.getNumChannels() > 0 && parameters.getRawParameterValue("sc audition")->load()) {
+        for (int channel = 0; channel < juce::jmin(getMainBusNumOutputChannels(), buffer.getNumChannels()); ++channel)
+            buffer.copyFrom(channel, 0, scBuffer, channel % scBuffer.getNumChannels(), 0, numSamples);
+    }
+    
+    if(buffer.getNumChannels() > 0)
+        outputHistory.push(buffer.getReadPointer(0), numSamples);
+    
+    //last, the CV bus shares its buffer channel with the sidechain input
+    writeModulationOutputs(buffer, midiMessages, numSamples);
+}
+
+void RectanglesAudioProcessor::processSyncBlock(juce::AudioBuffer<float>& buffer, int numSamples) {
+    ///the phase follows the host position, without a position the block stays unprocessed
+    auto ppq = positionInfo.getPpqPosition();
+    if (!ppq)
+        return;
+    
+    const double currentRate = lfoRate.load(std::memory_order_relaxed);
+    const double beatsPerSample = getBpm() / (60.0 * sampleRate);
+    auto time = positionInfo.getTimeInSamples();
+    if (!time || parameters.getRawParameterValue("deterministic")->load() < 0.5f) {
+        for (int sample = 0; sample < numSamples; ++sample) {
+            const double samplePpq = *ppq + sample * beatsPerSample;
+            const double continuousPhase = samplePpq * currentRate;
+            phase = continuousPhase - std::floor(continuousPhase);
+            processSample(sample, buffer);
+        }
+        return;
+    }
+    
+    ///deterministic, every sample's position is counted from the same anchor, so it doesn't depend on where the blocks start
+    ///the anchor only moves when the host position stops matching it, on a jump, a loop or a tempo change
+    const double expectedPpq = syncAnchorPpq + (double) (*time - syncAnchorSample) * syncAnchorBeatsPerSample;
+    if (syncAnchorSample < 0 || beatsPerSample != syncAnchorBeatsPerSample || std::abs(expectedPpq - *ppq) > 1.0e-6) {
+        syncAnchorPpq = *ppq;
+        syncAnchorSample = *time;
+        syncAnchorBeatsPerSample = beatsPerSample;
+    }
+    
+    for (int sample = 0; sample < numSamples; ++sample) {
+        const double samplePpq = syncAnchorPpq + (double) (*time + sample - syncAnchorSample) * beatsPerSample;
+        const double continuousPhase = samplePpq * currentRate;
+        phase = continuousPhase - std::floor(continuousPhase);
+        processSample(sample, buffer);
+    }
+}
+
+void RectanglesAudioProcessor::processTriggerBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples, double phaseIncrement) {
+    ///detection looks at the whole host block, a level above the threshold restarts the cycle at the start of the block,
+    ///a transient at the first onset in it
+    const int numScChannels = scBuffer.getNumChannels();
+    int triggerSample = -1;
+    
+    if (numScChannels > 0 && parameters.getRawParameterValue("sc trigger")->load() > 0.5f) {
+        triggerSample = transientDetector.process(scBuffer.getReadPointer(0), scBuffer.getReadPointer(numScChannels - 1), numSamples,
+                                                  parameters.getRawParameterValue("transient sensitivity")->load());
+    }
+    else if (numScChannels > 0) {
+        float meanRms = 0.0f;
+        for (int channel = 0; channel < numScChannels; ++channel)
+            meanRms += scBuffer.getRMSLevel(channel, 0, numSamples);
+        meanRms /= numScChannels;
+        if (meanRms > scThreshold.load(std::memory_order_relaxed))
+            triggerSample = 0;
+        previousRms = meanRms;
+    }
+    
+    //the part of the block before the trigger still plays the running cycle
+    if (triggerSample < 0) {
+        processTriggerSamples(buffer, 0, numSamples, phaseIncrement);
+        return;
+    }
+    processTriggerSamples(buffer, 0, triggerSample, phaseIncrement);
+    startTriggeredCycle();
+    processTriggerSamples(buffer, triggerSample, numSamples, phaseIncrement);
+}
+
+void RectanglesAudioProcessor::processDeterministicTriggerBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples, double phaseIncrement) {
+    ///detection runs on fixed windows of the stream, level windows of levelWindowSize samples or the detector's frames,
+    ///the block is cut at every window end so a trigger lands on the same sample whatever the host block size is
+    const int numScChannels = juce::jmin(2, scBuffer.getNumChannels());
+    if (numScChannels == 0) {
+        processTriggerSamples(buffer, 0, numSamples, phaseIncrement);
+        return;
+    }
+    
+    const float* left = scBuffer.getReadPointer(0);
+    const float* right = scBuffer.getReadPointer(numScChannels - 1);
+    const bool transient = parameters.getRawParameterValue("sc trigger")->load() > 0.5f;
+    const float sensitivity = parameters.getRawParameterValue("transient sensitivity")->load();
+    
+    for (int start = 0; start < numSamples;) {
+        const int untilWindowEnd = transient ? transientDetector.getSamplesUntilFrame() : levelWindowSize - levelWindowFill;
+        const int end = juce::jmin(numSamples, start + untilWindowEnd);
+        bool triggered = false;
+        
+        if (transient) {
+            triggered = transientDetector.process(left + start, right + start, end - start, sensitivity) >= 0;
+        } else {
+            for (int i = start; i < end; ++i) {
+                levelWindowSums[0] += left[i] * left[i];
+                levelWindowSums[1] += right[i] * right[i];
+            }
+            levelWindowFill += end - start;
+            if (levelWindowFill >= levelWindowSize) {
+                //mean of the channels' RMS like the block detection, a mono sidechain reads the same channel twice
+                const float meanRms = (float) (0.5 * (std::sqrt(levelWindowSums[0] / levelWindowFill) + std::sqrt(levelWindowSums[1] / levelWindowFill)));
+                triggered = meanRms > scThreshold.load(std::memory_order_relaxed);
+                previousRms = meanRms;
+                levelWindowSums.fill(0.0);
+                levelWindowFill = 0;
+            }
+        }
         
+        //the cycle starts on the last sample of the window that caught it
+        const int triggerSample = triggered ? end - 1 : end;
+        processTriggerSamples(buffer, start, triggerSample, phaseIncrement);
+        if (triggered)
+            startTriggeredCycle();
+        processTriggerSamples(buffer, triggerSample, end, phaseIncrement);
+        start = end;
+    }
+}
 
-    else { //if not sidechaining
-        curScRelease = scRelease;
-        if (parameters.getRawParameterValue("sync")->load())    {
-            if (auto ppq = positionInfo.getPpqPosition())
-            {
-                for (int sample = 0; sample < numSamples; ++sample)
-                {
-                    double samplePpq = *ppq + (sample / sampleRate) * getBpm() / 60.0f;
-                    double continuousPhase = samplePpq * lfoRate;
-                    phase = (continuousPhase - std::floor(continuousPhase));
-                    processSample(sample, buffer);
-                }
+void RectanglesAudioProcessor::processTriggerSamples(juce::AudioBuffer<float>& buffer, int start, int end, double phaseIncrement) {
+    ///plays a triggered cycle once, between cycles the phase rests on the last value of the curve
+    const double restingPhase = 1.0 - 1.0 / modulator.getResolution();
+    for (int sample = start; sample < end; ++sample) {
+        if (!lfoTriggered)
+            phase = restingPhase;
+        processSample(sample, buffer);
+        if (lfoTriggered) {
+            phase += phaseIncrement;
+            if (phase >= 1.0)
+                lfoTriggered = false;
+        }
+    }
+}
+
+void RectanglesAudioProcessor::startTriggeredCycle() {
+    lfoTriggered = true;
+    phase = 0.0;
+}
+
+juce::AudioBuffer<float> RectanglesAudioProcessor::getSidechainBuffer(juce::AudioBuffer<float>& buffer, int numSamples) {
+    ///the aux bus, run through the prefilter when one is selected
+    ///the result only refers to existing channel data, nothing is allocated
+    auto scBus = getBusBuffer(buffer, true, 1);
+    const int numChannels = juce::jmin(2, scBus.getNumChannels());
+    //blocks bigger than announced in prepareToPlay are detected unfiltered rather than allocating
+    if (!sidechainFilter.isActive() || numChannels == 0 || numSamples > scFilterBuffer.getNumSamples())
+        return scBus;
+    
+    sidechainFilter.process(scBus.getReadPointer(0), scBus.getReadPointer(numChannels - 1),
+                            scFilterBuffer.getWritePointer(0), scFilterBuffer.getWritePointer(1), numSamples);
+    return juce::AudioBuffer<float>(scFilterBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+}
+
+void RectanglesAudioProcessor::processScrubBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples) {
+    LFOTOOL_TRACE_SCOPE("processScrubBlock")
+    ///the sidechain envelope is the read position, silence sits at the start of the curve and full scale scrub range further in
+    ///rectifying and clamping run on whole chunks with the vector ops, the follower and the smoothing are scalar loops
+    ///the table is read interpolated from the mip level the fastest position change of the chunk needs
+    const int numScChannels = juce::jmin(2, scBuffer.getNumChannels());
+    setShowWarningLabel(numScChannels == 0);
+    const float* scLeft = numScChannels > 0 ? scBuffer.getReadPointer(0) : nullptr;
+    const float* scRight = numScChannels > 1 ? scBuffer.getReadPointer(1) : scLeft;
+    
+    //stays just below 1 so the position never wraps back to the start
+    const float range = parameters.getRawParameterValue("scrub range")->load() * 0.999f;
+    const float attack = 1.0f - std::exp(-1.0f / (0.005f * sampleRate));
+    const float release = 1.0f - std::exp(-1.0f / (parameters.getRawParameterValue("sc release")->load() * sampleRate));
+    float envelope = scrubEnvelope;
+    float* gain = modulationBuffer.getWritePointer(0);
+    float* offsetGain = modulationBuffer.getWritePointer(1);
+    const int chunkSize = modulationBuffer.getNumSamples();
+    if (chunkSize == 0)
+        return;
+    
+    //fills positions with the read positions of the chunk, returns the largest step between two of them
+    auto follow = [&](int start, int length, float* positions, float* scratch) {
+        if (scLeft != nullptr) {
+            juce::FloatVectorOperations::abs(positions, scLeft + start, length);
+            juce::FloatVectorOperations::abs(scratch, scRight + start, length);
+            juce::FloatVectorOperations::max(positions, positions, scratch, length);
+        }
+        else {
+            juce::FloatVectorOperations::clear(positions, length);
+        }
+        
+        float maxStep = 0.0f;
+        for (int i = 0; i < length; ++i) {
+            const float step = (positions[i] > envelope ? attack : release) * (positions[i] - envelope);
+            envelope += step;
+            maxStep = juce::jmax(maxStep, std::abs(step));
+            positions[i] = envelope;
+        }
+        juce::FloatVectorOperations::min(positions, positions, 1.0f, length);
+        juce::FloatVectorOperations::multiply(positions, range, length);
+        return maxStep * range;
+    };
+    
+    auto table = modulator.getTable();
+    if (filterDestination || numBands > 1 || table == nullptr || table->values.empty()) {
+        //these stages evaluate per sample anyway, only the phase is scrubbed
+        for (int start = 0; start < numSamples; start += chunkSize) {
+            const int length = juce::jmin(chunkSize, numSamples - start);
+            follow(start, length, gain, offsetGain);
+            for (int i = 0; i < length; ++i) {
+                phase = gain[i];
+                processSample(start + i, buffer);
             }
         }
-        else    {
-            for (int sample = 0; sample < numSamples; ++sample) {
-                processSample(sample, buffer);
-                phase = std::fmod(phase + delta_f, 1.0f);
+        scrubEnvelope = envelope;
+        return;
+    }
+    
+    const int numChannels = juce::jmin(getMainBusNumOutputChannels(), buffer.getNumChannels(), (int) lfoSmoothed.size());
+    const float currentDepth = depth.load(std::memory_order_relaxed);
+    const float currentPanOffset = panOffset.load(std::memory_order_relaxed);
+    const bool usePanOffset = currentPanOffset != 0.0f && numChannels > 1;
+    
+    //the same smoothing and hard edge handling as processSample, even channels share one smoother and odd ones the other
+    float smoothedMain = lfoSmoothed.empty() ? 1.0f : lfoSmoothed[0];
+    float smoothedOffset = lfoSmoothed.size() > 1 ? lfoSmoothed[1] : smoothedMain;
+    auto smooth = [this, currentDepth](float& smoothed, float value, bool hardEdge) {
+        const float rawMod = value * currentDepth;
+        smoothed += smoothingCoefficient * (rawMod - smoothed);
+        if (hardEdge)
+            smoothed = rawMod;
+        if (std::abs(smoothed) < 0.001f)
+            smoothed = 0.0f;
+        return (1.0f - currentDepth) + smoothed;
+    };
+    
+    for (int start = 0; start < numSamples; start += chunkSize) {
+        const int length = juce::jmin(chunkSize, numSamples - start);
+        //a fast attack sweeps through the curve like a fast LFO would, so it reads the same band-limited levels
+        const float mip = modulator.getMipLevel(follow(start, length, gain, offsetGain));
+        phase = gain[length - 1];
+        const int numOutputValues = juce::jlimit(0, length, (int) modulationOutput.size() - start);
+        
+        for (int i = 0; i < length; ++i) {
+            bool hardEdge;
+            const float value = modulator.readTable(*table, gain[i], mip, hardEdge);
+            float offsetValue = value;
+            bool offsetHardEdge = hardEdge;
+            if (usePanOffset) {
+                float offsetPosition = gain[i] + currentPanOffset;
+                offsetPosition -= std::floor(offsetPosition);
+                offsetValue = modulator.readTable(*table, offsetPosition, mip, offsetHardEdge);
             }
+            gain[i] = smooth(smoothedMain, value, hardEdge);
+            offsetGain[i] = smooth(smoothedOffset, offsetValue, offsetHardEdge);
+            if (i < numOutputValues)
+                modulationOutput[(size_t) (start + i)] = smoothedMain;
+        }
+        
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* channelGain = channel % 2 == 1 ? offsetGain : gain;
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, start), channelGain, length);
+        }
+    }
+    
+    for (size_t channel = 0; channel < lfoSmoothed.size(); ++channel)
+        lfoSmoothed[channel] = channel % 2 == 1 ? smoothedOffset : smoothedMain;
+    scrubEnvelope = envelope;
+}
+
+void RectanglesAudioProcessor::writeModulationOutputs(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numSamples) {
+    LFOTOOL_TRACE_SCOPE("writeModulationOutputs")
+    ///the CV bus and the CC stream both read modulationOutput, nothing is evaluated twice
+    const int numValues = juce::jmin(numSamples, (int) modulationOutput.size());
+    if (numValues > 0)
+        lastModulationOutput = modulationOutput[(size_t) numValues - 1];
+    
+    if (getBusCount(false) > 1) {
+        auto cvBuffer = getBusBuffer(buffer, false, 1);
+        for (int channel = 0; channel < cvBuffer.getNumChannels(); ++channel) {
+            cvBuffer.copyFrom(channel, 0, modulationOutput.data(), numValues);
+            if (numValues < numSamples)
+                cvBuffer.clear(channel, numValues, numSamples - numValues);
+        }
+    }
+    
+    if (!parameters.getRawParameterValue("cc output")->load())
+        return;
+    
+    //one value every interval samples, only sent when it changed
+    const int interval = juce::jmax(1, juce::roundToInt(sampleRate / parameters.getRawParameterValue("cc rate")->load()));
+    const int controller = (int) parameters.getRawParameterValue("cc number")->load();
+    for (; ccCountdown < numValues; ccCountdown += interval) {
+        const int value = juce::jlimit(0, 127, juce::roundToInt(modulationOutput[(size_t) ccCountdown] * 127.0f));
+        if (value != lastCcValue) {
+            midiMessages.addEvent(juce::MidiMessage::controllerEvent(1, controller, value), ccCountdown);
+            lastCcValue = value;
         }
     }
+    ccCountdown = juce::jmax(0, ccCountdown - numSamples);
 }
 
 void RectanglesAudioProcessor::processSample(int sample, juce::AudioBuffer<float>& buffer) {
     
+    if (filterDestination) {
+        processFilterSample(sample, buffer);
+        return;
+    }
+    
+    if (numBands > 1) {
+        processMultibandSample(sample, buffer);
+        return;
+    }
+    
     float rawMod;
+    bool hardEdge;
+    //only the main bus, the other channels belong to the sidechain and the CV output
+    const int numChannels = juce::jmin(getMainBusNumOutputChannels(), buffer.getNumChannels(), (int) lfoSmoothed.size());
     //const float effectiveDepth = depth * (curScRelease / scRelease);
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    const float currentDepth = depth.load(std::memory_order_relaxed);
+    const float currentPanOffset = panOffset.load(std::memory_order_relaxed);
+    for (int channel = 0; channel < numChannels; ++channel)
     {
         auto* channelData = buffer.getWritePointer(channel);
         if(channel % 2 == 0)    {
-            rawMod = modulator.getModulationValue(phase) * depth;
+            rawMod = modulator.getModulationValue(phase, mipLevel, hardEdge) * currentDepth;
         }
         else    {
-            float wrappedPhase = std::fmod(std::fmod(phase+panOffset, 1.0f) + 1.0f, 1.0f);
-            rawMod = modulator.getModulationValue(wrappedPhase) * depth;
+            float wrappedPhase = std::fmod(std::fmod(phase+currentPanOffset, 1.0f) + 1.0f, 1.0f);
+            rawMod = modulator.getModulationValue(wrappedPhase, mipLevel, hardEdge) * currentDepth;
         }
         float& smoothed = lfoSmoothed[channel];
-        smoothed += smoothing * (rawMod - smoothed);
+        smoothed += smoothingCoefficient * (rawMod - smoothed);
+        //hold segments are meant to jump, don't let the smoother round them off
+        if (hardEdge)
+            smoothed = rawMod;
         //find good value for smoothing to get absolute 0 when no modulation
         if (std::abs(smoothed) < 0.001f)
             smoothed = 0.0f;
-        channelData[sample] *= (1.0f - depth) + smoothed;
+        channelData[sample] *= (1.0f - currentDepth) + smoothed;
+        if (channel == 0 && sample < (int) modulationOutput.size())
+            modulationOutput[(size_t) sample] = smoothed;
+    }
+}
+
+void RectanglesAudioProcessor::prepareMultibandBlock() {
+    ///read the band parameters and take every band's table once for the whole block
+    for (auto& table : bandTables)
+        table.reset();
+    numBands = 1 + (int) parameters.getRawParameterValue("bands")->load();
+    crossover.setNumBands(numBands);
+    if (numBands <= 1)
+        return;
+    
+    crossover.setCrossoverFrequencies(parameters.getRawParameterValue("crossover 1")->load(),
+                                      parameters.getRawParameterValue("crossover 2")->load(),
+                                      parameters.getRawParameterValue("crossover 3")->load());
+    
+    for (int band = 0; band < numBands; ++band) {
+        bandDepths[band] = depth.load(std::memory_order_relaxed) * bandDepthParameters[band]->load();
+        bandPhases[band] = bandPhaseParameters[band]->load();
+        bandTables[band] = getBandModulator(band).getTable();
     }
 }
 
+void RectanglesAudioProcessor::processMultibandSample(int sample, juce::AudioBuffer<float>& buffer) {
+    ///split the main bus into bands, modulate every band with its own shape and sum them up again
+    ///only the main stereo pair is processed, the sidechain channels stay untouched
+    const int numChannels = juce::jmin(2, getMainBusNumInputChannels(), buffer.getNumChannels());
+    if (numChannels == 0)
+        return;
+    
+    float* left = buffer.getWritePointer(0);
+    float* right = numChannels > 1 ? buffer.getWritePointer(1) : nullptr;
+    
+    float bands[maxBands][2];
+    crossover.process(left[sample], right != nullptr ? right[sample] : left[sample], bands);
+    
+    const float currentPanOffset = panOffset.load(std::memory_order_relaxed);
+    float output[2] = { 0.0f, 0.0f };
+    for (int band = 0; band < numBands; ++band) {
+        const float bandDepth = bandDepths[band];
+        for (int channel = 0; channel < numChannels; ++channel) {
+            double bandPhase = phase + bandPhases[band] + (channel == 1 ? currentPanOffset : 0.0f);
+            bandPhase -= std::floor(bandPhase);
+            
+            bool hardEdge = false;
+            float rawMod = bandDepth;
+            if (bandTables[band] != nullptr && !bandTables[band]->values.empty())
+                rawMod *= getBandModulator(band).readTable(*bandTables[band], (float) bandPhase, mipLevel, hardEdge);
+            
+            float& smoothed = bandSmoothed[band][channel];
+            smoothed += smoothingCoefficient * (rawMod - smoothed);
+            if (hardEdge)
+                smoothed = rawMod;
+            output[channel] += bands[band][channel] * ((1.0f - bandDepth) + smoothed);
+        }
+    }
+    
+    //CV and CC send the lowest band, its shape is the one used without crossover, so the exported curve
+    //doesn't change when bands are switched on
+    if (sample < (int) modulationOutput.size())
+        modulationOutput[(size_t) sample] = bandSmoothed[0][0];
+    
+    left[sample] = output[0];
+    if (right != nullptr)
+        right[sample] = output[1];
+}
 
+void RectanglesAudioProcessor::prepareFilterBlock() {
+    ///the filter replaces the gain stage (and the band split) while it is the destination
+    filterDestination = parameters.getRawParameterValue("destination")->load() > 0.5f;
+    if (!filterDestination)
+        return;
+    
+    const auto type = (ModulatedFilter::Type) (int) parameters.getRawParameterValue("filter type")->load();
+    if (type != filter.getType()) {
+        filter.setType(type);
+        filter.reset();
+    }
+    
+    filterCutoffPosition = ModulatedFilter::frequencyToPosition(parameters.getRawParameterValue("cutoff")->load());
+    filterRange = parameters.getRawParameterValue("filter range")->load() / ModulatedFilter::getNumOctaves();
+    filterResonance = parameters.getRawParameterValue("resonance")->load();
+    filterResonanceMod = parameters.getRawParameterValue("resonance mod")->load();
+    //the smoother only runs once per coefficient update
+    filterSmoothingCoefficient = juce::jmin(1.0f, smoothingCoefficient * ModulatedFilter::updateInterval);
+}
+
+void RectanglesAudioProcessor::processFilterSample(int sample, juce::AudioBuffer<float>& buffer) {
+    ///the shape moves the cutoff up from the cutoff parameter by up to filter range octaves
+    ///the curve is only read when the coefficients are updated, every ModulatedFilter::updateInterval samples
+    const int numChannels = juce::jmin(2, getMainBusNumOutputChannels(), buffer.getNumChannels(), (int) lfoSmoothed.size());
+    //counted on the stream, not the block, so the updates land on the same samples for any block size
+    const bool updateCoefficients = (blockStartSample + sample) % ModulatedFilter::updateInterval == 0;
+    const float currentDepth = depth.load(std::memory_order_relaxed);
+    const float currentPanOffset = panOffset.load(std::memory_order_relaxed);
+    
+    for (int channel = 0; channel < numChannels; ++channel) {
+        if (updateCoefficients) {
+            double channelPhase = phase + (channel == 1 ? currentPanOffset : 0.0f);
+            channelPhase -= std::floor(channelPhase);
+            
+            bool hardEdge;
+            const float rawMod = modulator.getModulationValue((float) channelPhase, mipLevel, hardEdge) * currentDepth;
+            float& smoothed = lfoSmoothed[channel];
+            smoothed += filterSmoothingCoefficient * (rawMod - smoothed);
+            if (hardEdge)
+                smoothed = rawMod;
+            
+            const float resonance = filterResonance + filterResonanceMod * smoothed * (ModulatedFilter::maxResonance - filterResonance);
+            filter.setCoefficients(channel, filterCutoffPosition + smoothed * filterRange, resonance);
+        }
+        
+        auto* channelData = buffer.getWritePointer(channel);
+        channelData[sample] = filter.processSample(channel, channelData[sample]);
+    }
+    
+    if (numChannels > 0 && sample < (int) modulationOutput.size())
+        modulationOutput[(size_t) sample] = lfoSmoothed[0];
+}
+
+Modulator& RectanglesAudioProcessor::getBandModulator(int band) {
+    return band == 0 ? modulator : bandModulators[(size_t) band - 1];
+}
+
+void RectanglesAudioProcessor::processAudioRate(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, ModulationMode mode) {
+    LFOTOOL_TRACE_SCOPE("processAudioRate")
+    ///the shape as an audio rate oscillator, either following the last held note or running at lfoRate
+    for (const auto metadata : midiMessages) {
+        auto message = metadata.getMessage();
+        if (message.isNoteOn())
+            currentNote = message.getNoteNumber();
+        else if (message.isNoteOff() && message.getNoteNumber() == currentNote)
+            currentNote = -1;
+    }
+    
+    //synced, lfoRate is a multiple of the beat, not Hz
+    double frequency = getCyclesPerSecond();
+    if (parameters.getRawParameterValue("note track")->load() && currentNote >= 0)
+        frequency = juce::MidiMessage::getMidiNoteInHertz(currentNote);
+    
+    const int factorIndex = juce::jlimit(0, (int) oversamplers.size() - 1, (int) parameters.getRawParameterValue("oversampling")->load());
+    auto& oversampler = *oversamplers[factorIndex];
+    //a factor that wasn't used for the last block still holds the filter state from whenever it was
+    if (factorIndex != activeOversampler) {
+        oversampler.reset();
+        activeOversampler = factorIndex;
+    }
+    updateLatency(juce::roundToInt(oversampler.getLatencyInSamples()));
+    
+    const double phaseIncrement = frequency / (sampleRate * oversampler.getOversamplingFactor());
+    
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    juce::dsp::AudioBlock<float> block(mainBuffer);
+    const int factor = (int) oversampler.getOversamplingFactor();
+    
+    //the shaper has no modulation signal to send out
+    std::fill(modulationOutput.begin(), modulationOutput.end(), 0.0f);
+    
+    //the oversampler is prepared for preparedBlockSize, bigger host blocks are split
+    for (size_t start = 0; start < block.getNumSamples(); start += (size_t) preparedBlockSize) {
+        auto subBlock = block.getSubBlock(start, juce::jmin((size_t) preparedBlockSize, block.getNumSamples() - start));
+        auto upsampled = oversampler.processSamplesUp(subBlock);
+        const bool fitsOutput = start + subBlock.getNumSamples() <= modulationOutput.size();
+        renderAudioRateBlock(upsampled, mode, phaseIncrement, fitsOutput ? modulationOutput.data() + start : nullptr, factor);
+        oversampler.processSamplesDown(subBlock);
+    }
+    
+    if (mode == ModulationMode::Shaper)
+        removeDC(block);
+}
+
+void RectanglesAudioProcessor::renderAudioRateBlock(juce::dsp::AudioBlock<float>& block, ModulationMode mode, double phaseIncrement, float* modulationDestination, int oversamplingFactor) {
+    ///render the oscillator once per block, turn it into a gain curve and multiply it in with the vector ops
+    ///modulationDestination gets every oversamplingFactor-th value at the host rate for the CV output
+    const int numSamples = (int) block.getNumSamples();
+    const float currentDepth = depth.load(std::memory_order_relaxed);
+    const float currentPanOffset = panOffset.load(std::memory_order_relaxed);
+    
+    if (mode == ModulationMode::Shaper) {
+        //the input picks the position on the curve, depth is the dry/wet mix
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            modulator.shapeBlock(block.getChannelPointer(channel), modulationBuffer.getWritePointer(0), numSamples, currentDepth);
+        return;
+    }
+    
+    const float mip = modulator.getMipLevel(phaseIncrement);
+    float* gain = modulationBuffer.getWritePointer(0);
+    float* offsetGain = modulationBuffer.getWritePointer(1);
+    
+    //AM: (1 - depth) + depth * m, ring: (1 - depth) + depth * (2m - 1) with the shape as a bipolar waveform
+    const float scale = mode == ModulationMode::Ring ? 2.0f * currentDepth : currentDepth;
+    const float offset = mode == ModulationMode::Ring ? 1.0f - 2.0f * currentDepth : 1.0f - currentDepth;
+    
+    const double startPhase = phase;
+    phase = modulator.renderModulation(gain, numSamples, startPhase, phaseIncrement, mip);
+    if (modulationDestination != nullptr) {
+        for (int i = 0; i < numSamples / oversamplingFactor; ++i)
+            modulationDestination[i] = currentDepth * gain[i * oversamplingFactor];
+    }
+    juce::FloatVectorOperations::multiply(gain, scale, numSamples);
+    juce::FloatVectorOperations::add(gain, offset, numSamples);
+    
+    const bool usePanOffset = currentPanOffset != 0.0f && block.getNumChannels() > 1;
+    if (usePanOffset) {
+        double offsetPhase = std::fmod(std::fmod(startPhase + currentPanOffset, 1.0) + 1.0, 1.0);
+        modulator.renderModulation(offsetGain, numSamples, offsetPhase, phaseIncrement, mip);
+        juce::FloatVectorOperations::multiply(offsetGain, scale, numSamples);
+        juce::FloatVectorOperations::add(offsetGain, offset, numSamples);
+    }
+    
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel) {
+        const float* channelGain = (usePanOffset && channel % 2 == 1) ? offsetGain : gain;
+        juce::FloatVectorOperations::multiply(block.getChannelPointer(channel), channelGain, numSamples);
+    }
+}
+
+void RectanglesAudioProcessor::removeDC(juce::dsp::AudioBlock<float>& block) {
+    for (size_t channel = 0; channel < block.getNumChannels() && channel < dcLastInput.size(); ++channel) {
+        float* data = block.getChannelPointer(channel);
+        float lastInput = dcLastInput[channel];
+        float lastOutput = dcLastOutput[channel];
+        for (size_t i = 0; i < block.getNumSamples(); ++i) {
+            const float input = data[i];
+            lastOutput = input - lastInput + dcCoefficient * lastOutput;
+            lastInput = input;
+            data[i] = lastOutput;
+        }
+        dcLastInput[channel] = lastInput;
+        dcLastOutput[channel] = lastOutput;
+    }
+}
+
+void RectanglesAudioProcessor::updateLatency(int latencySamples) {
+    ///only tell the host when the oversampling latency actually changes
+    ///the host is told from the message thread, hosts may do anything in their latency callback
+    if (latencySamples != reportedLatency) {
+        reportedLatency = latencySamples;
+        pendingLatency.store(latencySamples, std::memory_order_relaxed);
+        //posting the message can take the message queue's lock on some platforms, accepted since it only happens when the oversampling changes
+        const RealtimeGuard::ScopedAllow allowPost;
+        triggerAsyncUpdate();
+    }
+}
+
+int RectanglesAudioProcessor::getLatencyForParameters() const {
+    ///what processBlock will report for the current mode, only the audio rate modes oversample
+    if ((ModulationMode) (int) parameters.getRawParameterValue("mode")->load() == ModulationMode::LFO)
+        return 0;
+    const int factorIndex = juce::jlimit(0, (int) oversamplers.size() - 1, (int) parameters.getRawParameterValue("oversampling")->load());
+    return juce::roundToInt(oversamplers[(size_t) factorIndex]->getLatencyInSamples());
+}
+
+void RectanglesAudioProcessor::handleAsyncUpdate() {
+    setLatencySamples(pendingLatency.load(std::memory_order_relaxed));
+}
 
 //==============================================================================
 bool RectanglesAudioProcessor::hasEditor() const
@@ -267,15 +966,25 @@ juce::AudioProcessorEditor* RectanglesAudioProcessor::createEditor()
 //==============================================================================
 void RectanglesAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
+    LFOTOOL_TRACE_SCOPE("getStateInformation")
     auto stateXml = parameters.copyState().createXml();
     
     if (stateXml != nullptr)
     {
-        if (shapeGraphXmlString.isNotEmpty())
+        //band 0 stays a plain ShapeGraph child so older versions still load it
+        for (int band = 0; band < maxBands; ++band)
         {
+            auto shapeGraphXmlString = getShapeGraphXmlString(band);
+            if (shapeGraphXmlString.isEmpty())
+                continue;
+            
             auto shapeXml = juce::XmlDocument::parse(shapeGraphXmlString);
             if (shapeXml != nullptr)
+            {
+                if (band > 0)
+                    shapeXml->setAttribute("band", band);
                 stateXml->addChildElement(shapeXml.release());
+            }
         }
         
         copyXmlToBinary(*stateXml, destData);
@@ -285,24 +994,148 @@ void RectanglesAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 
 void RectanglesAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
+    LFOTOOL_TRACE_SCOPE("setStateInformation")
+    ///everything here comes from the host, so the work is bounded: the size and nesting are checked before parsing,
+    ///every band compiles at most one shape and the shape graph caps its node count
+    if (!isStateWithinLimits(data, sizeInBytes))
+        return;
+    
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
-    if (xmlState != nullptr)
+    if (xmlState != nullptr && xmlState->hasTagName(parameters.state.getType()))
     {
+        //states from before the rate range was extended store the rate under its old id, the value means the same either way
+        if (xmlState->getChildByAttribute("id", "lfo rate") == nullptr)
+            if (auto* legacyRate = xmlState->getChildByAttribute("id", "lfoRate"))
+                legacyRate->setAttribute("id", "lfo rate");
+        
         // Restore parameter state
         parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+        
+        //a corrupted value would otherwise go straight into the dsp
+        for (auto* parameter : getParameters())
+            if (!std::isfinite(parameter->getValue()))
+                parameter->setValueNotifyingHost(parameter->getDefaultValue());
 
-        // Restore and apply shape graph
-        if (auto* shapeXml = xmlState->getChildByName("ShapeGraph"))
+        // Restore and apply the shape graph of every band, if a band is listed more than once the last one counts
+        std::array<juce::XmlElement*, maxBands> bandShapes {};
+        for (auto* shapeXml : xmlState->getChildWithTagNameIterator("ShapeGraph"))
         {
-            shapeGraphXmlString = shapeXml->toString();
+            const int band = shapeXml->getIntAttribute("band", 0);
+            if (juce::isPositiveAndBelow(band, maxBands))
+                bandShapes[band] = shapeXml;
+        }
+        
+        for (int band = 0; band < maxBands; ++band)
+        {
+            if (bandShapes[band] == nullptr)
+                continue;
+            
+            bandShapes[band]->removeAttribute("band");
+            loadShapeGraphXml(*bandShapes[band], band);
+        }
+        
+        syncParameterMembers();
+    }
+}
 
-            // Rebuild and apply shape graph to modulator
-            ShapeGraph restoredGraph;
-            restoredGraph.loadXML(*shapeXml);
-            updateLfoData(restoredGraph); // Ensure modulation values match
+bool RectanglesAudioProcessor::isStateWithinLimits(const void* data, int sizeInBytes)
+{
+    ///the xml parser recurses once per nesting level, so the depth is counted on the raw text first
+    ///comments, cdata and declarations are skipped and quoted attribute values are ignored, so the count never
+    ///comes out lower than what the parser will see
+    if (data == nullptr || sizeInBytes <= 0 || sizeInBytes > maxStateSize)
+        return false;
+    
+    const auto* text = static_cast<const char*>(data);
+    const auto* end = text + sizeInBytes;
+    
+    auto skipPast = [&end](const char* position, const char* terminator)
+    {
+        const auto length = std::strlen(terminator);
+        const auto* found = std::search(position, end, terminator, terminator + length);
+        return found == end ? end : found + length;
+    };
+    
+    auto startsWith = [&end](const char* position, const char* prefix)
+    {
+        const auto length = std::strlen(prefix);
+        return (size_t) (end - position) >= length && std::equal(prefix, prefix + length, position);
+    };
+    
+    int depth = 0;
+    for (const auto* position = text; position < end;)
+    {
+        if (*position != '<')
+        {
+            ++position;
+            continue;
+        }
+        
+        if (startsWith(position, "<!--"))
+            position = skipPast(position, "-->");
+        else if (startsWith(position, "<![CDATA["))
+            position = skipPast(position, "]]>");
+        else if (startsWith(position, "<!") || startsWith(position, "<?"))
+            position = skipPast(position, ">");
+        else if (startsWith(position, "</"))
+        {
+            depth = juce::jmax(0, depth - 1);
+            position = skipPast(position, ">");
+        }
+        else
+        {
+            //an opening tag, walk to its end to see whether it closes itself
+            if (++depth > maxStateDepth)
+                return false;
+            
+            char quote = 0;
+            for (++position; position < end; ++position)
+            {
+                if (quote != 0)
+                {
+                    if (*position == quote)
+                        quote = 0;
+                }
+                else if (*position == '"' || *position == '\'')
+                    quote = *position;
+                else if (*position == '>')
+                {
+                    if (position[-1] == '/')
+                        --depth;
+                    ++position;
+                    break;
+                }
+            }
         }
     }
+    
+    return true;
+}
+
+void RectanglesAudioProcessor::loadShapeGraphXml(juce::XmlElement& shapeXml, int band)
+{
+    ///store the shape for saving and compile it right away, also used by the command line tools
+    if (!juce::isPositiveAndBelow(band, maxBands))
+        return;
+    
+    setShapeGraphXmlString(shapeXml.toString(), band);
+
+    // Rebuild and apply shape graph to modulator
+    ShapeGraph restoredGraph;
+    restoredGraph.loadXML(shapeXml);
+    shapeCompiler.compileNow(Modulator::createSegments(&restoredGraph), band); // Ensure modulation values match
+}
+
+void RectanglesAudioProcessor::syncParameterMembers()
+{
+    ///the editor pushes these through the setters, without an editor (offline rendering) they come from the parameters
+    lfoRate.store(parameters.getRawParameterValue("lfo rate")->load(), std::memory_order_relaxed);
+    depth.store(parameters.getRawParameterValue("depth")->load(), std::memory_order_relaxed);
+    panOffset.store(parameters.getRawParameterValue("pan offset")->load(), std::memory_order_relaxed);
+    scThreshold.store(parameters.getRawParameterValue("sc threshold")->load(), std::memory_order_relaxed);
+    scRelease.store(parameters.getRawParameterValue("sc release")->load(), std::memory_order_relaxed);
+    scActivated.store(parameters.getRawParameterValue("sc")->load() > 0.5f, std::memory_order_relaxed);
 }
 
 
@@ -327,48 +1160,72 @@ double RectanglesAudioProcessor::getBpm() {
 }
 
 void RectanglesAudioProcessor::setDepth(float depth) {
-    this->depth = depth;
+    this->depth.store(depth, std::memory_order_relaxed);
 }
 
 void RectanglesAudioProcessor::setPanOffset(float offset) {
-    panOffset = offset;
+    panOffset.store(offset, std::memory_order_relaxed);
 }
 
 void RectanglesAudioProcessor::setSCThreshold(float threshold) {
-    scThreshold = threshold;
+    scThreshold.store(threshold, std::memory_order_relaxed);
 }
 
 void RectanglesAudioProcessor::setSCRelease(float release) {
-    scRelease = release;
+    scRelease.store(release, std::memory_order_relaxed);
 }
 
 void RectanglesAudioProcessor::setScActivated(bool activated) {
-    scActivated = activated;
+    scActivated.store(activated, std::memory_order_relaxed);
 }
 
 void RectanglesAudioProcessor::setLfoRate(float rate) {
-    lfoRate = rate;
+    lfoRate.store(rate, std::memory_order_relaxed);
+}
+
+void RectanglesAudioProcessor::setShowWarningLabel(bool show) {
+    ///only written when it changes, the editor polls it and a store every block would keep taking the line away from it
+    if (showWarningLabel.load(std::memory_order_relaxed) != show)
+        showWarningLabel.store(show, std::memory_order_relaxed);
 }
 
 double RectanglesAudioProcessor::getPhase()
 {
-    if(!scActivated && parameters.getRawParameterValue("sync")->load())   {
+    if(!scActivated.load(std::memory_order_relaxed) && parameters.getRawParameterValue("sync")->load())   {
             if (auto ppq = positionInfo.getPpqPosition())
             {
-                double continuousPhase = *ppq * lfoRate;
+                double continuousPhase = *ppq * lfoRate.load(std::memory_order_relaxed);
                 return std::fmod(continuousPhase, 1.0);
             }
         }
     return phase;
 }
+
+double RectanglesAudioProcessor::getCyclesPerSecond()
+{
+    ///how many LFO cycles pass per second, used to line the waveform history up with the shape
+    if(parameters.getRawParameterValue("sync")->load())
+        return getBpm() / 60.0 * lfoRate.load(std::memory_order_relaxed);
+    return lfoRate.load(std::memory_order_relaxed);
+}
     
 
 
-void RectanglesAudioProcessor::updateLfoData(const ShapeGraph& shapeGraph) {
-    modulator.generateModulationValues(&shapeGraph);
+void RectanglesAudioProcessor::updateLfoData(const ShapeGraph& shapeGraph, int band) {
+    ///only extracts the segments here, the table itself is built on the compiler thread
+    shapeCompiler.submit(Modulator::createSegments(&shapeGraph), band);
+}
+
+void RectanglesAudioProcessor::setShapeGraphXmlString(const juce::String& xmlString, int band)
+{
+    if (juce::isPositiveAndBelow(band, maxBands))
+        std::atomic_store(&shapeGraphXml[(size_t) band], std::make_shared<const juce::String>(xmlString));
 }
 
-void RectanglesAudioProcessor::setShapeGraphXmlString(const juce::String& xmlString)
+juce::String RectanglesAudioProcessor::getShapeGraphXmlString(int band)
 {
-    shapeGraphXmlString = xmlString;
+    if (!juce::isPositiveAndBelow(band, maxBands))
+        return {};
+    auto xml = std::atomic_load(&shapeGraphXml[(size_t) band]);
+    return xml != nullptr ? *xml : juce::String();
 }
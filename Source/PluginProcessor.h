@@ -10,14 +10,27 @@
 
 #include <JuceHeader.h>
 #include "Modulator.h"
+#include "MultibandCrossover.h"
+#include "ModulatedFilter.h"
+#include "SidechainFilter.h"
+#include "TransientDetector.h"
+#include "ShapeCompiler.h"
 #include "ShapeGraph.h"
+#include "WaveformHistory.h"
+#include "LoadMeter.h"
 
 //==============================================================================
 
 
-class RectanglesAudioProcessor  : public juce::AudioProcessor
+class RectanglesAudioProcessor  : public juce::AudioProcessor, private juce::AsyncUpdater
 {
 public:
+    //what the shape drives, matches the "mode" parameter
+    enum class ModulationMode { LFO, AM, Ring, Shaper };
+    
+    //each band has its own shape, band 0 is also the shape used without crossover
+    static constexpr int maxBands = MultibandCrossover::maxBands;
+    
     //==============================================================================
     RectanglesAudioProcessor();
     ~RectanglesAudioProcessor() override;
@@ -65,42 +78,145 @@ public:
     void setSCThreshold(float threshold);
     void setSCRelease(float release);
     void setLfoRate(float rate);
-    void updateLfoData(const ShapeGraph& shapeGraph);
+    void updateLfoData(const ShapeGraph& shapeGraph, int band = 0);
     double getPhase();
+    double getCyclesPerSecond();
     void setScActivated(bool activated);
+    ///polled by the editor, true while a sidechain mode runs without a sidechain input
+    bool shouldShowWarningLabel() const { return showWarningLabel.load(std::memory_order_relaxed); }
+    
+    void setShapeGraphXmlString(const juce::String& xmlString, int band = 0);
+    juce::String getShapeGraphXmlString(int band = 0);
+    void loadShapeGraphXml(juce::XmlElement& shapeXml, int band = 0);
     
-    void setShapeGraphXmlString(const juce::String& xmlString);
+    //host supplied state that is bigger or nested deeper than any saved state is rejected before parsing
+    static constexpr int maxStateSize = 8 << 20;
+    static constexpr int maxStateDepth = 32;
+    static bool isStateWithinLimits(const void* data, int sizeInBytes);
     
     juce::AudioPlayHead::PositionInfo positionInfo;
     juce::AudioProcessorValueTreeState parameters;
-    juce::String shapeGraphXmlString;
-    
-    bool showWarningLabel;
+    WaveformHistory inputHistory;
+    WaveformHistory outputHistory;
+    LoadMeter loadMeter;
 
 private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RectanglesAudioProcessor)
     void processSample(int sample, juce::AudioBuffer<float>& buffer);
+    void processMultibandSample(int sample, juce::AudioBuffer<float>& buffer);
+    void prepareMultibandBlock();
+    void processFilterSample(int sample, juce::AudioBuffer<float>& buffer);
+    void prepareFilterBlock();
+    void processScrubBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples);
+    void processTriggerBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples, double phaseIncrement);
+    void processDeterministicTriggerBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& scBuffer, int numSamples, double phaseIncrement);
+    void processTriggerSamples(juce::AudioBuffer<float>& buffer, int start, int end, double phaseIncrement);
+    void startTriggeredCycle();
+    void processSyncBlock(juce::AudioBuffer<float>& buffer, int numSamples);
+    juce::AudioBuffer<float> getSidechainBuffer(juce::AudioBuffer<float>& buffer, int numSamples);
+    void writeModulationOutputs(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numSamples);
+    Modulator& getBandModulator(int band);
+    void processAudioRate(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, ModulationMode mode);
+    void renderAudioRateBlock(juce::dsp::AudioBlock<float>& block, ModulationMode mode, double phaseIncrement, float* modulationDestination, int oversamplingFactor);
+    void updateLatency(int latencySamples);
+    int getLatencyForParameters() const;
+    void handleAsyncUpdate() override;
+    void syncParameterMembers();
+    void setShowWarningLabel(bool show);
+    void removeDC(juce::dsp::AudioBlock<float>& block);
+    
+    //written by the editor through the setters and read by the audio thread, relaxed is enough as every value stands on its own
+    //they get a cache line of their own, so an editor write doesn't invalidate the audio thread's state below
+    alignas(64) std::atomic<float> lfoRate { 1.0f };
+    std::atomic<float> depth { 1.0f };
+    std::atomic<float> panOffset { 0.0f };
+    std::atomic<float> scThreshold { 0.0f };
+    std::atomic<float> scRelease { 0.01f };
+    std::atomic<bool> scActivated { false };
     
     juce::Random random;
+    
+    //last published shape per band, swapped atomically so the host can save state from any thread
+    std::array<std::shared_ptr<const juce::String>, maxBands> shapeGraphXml;
     std::vector<std::pair<float, float>> lfoShape;
     
-    float scThreshold = 0.0f;
-    float scRelease = 0.01f;
-    double curScRelease = scRelease;
+    //per sample state of the audio thread, starts on a line of its own
+    alignas(64) double phase = 0.0;
+    //written by the audio thread only when it changes, the editor's reads leave the line shared
+    std::atomic<bool> showWarningLabel { false };
+    double curScRelease = 0.01;
     float lfoTriggered = false;
-    bool scActivated;
     float previousRms = 0.0f;
+    float sampleRate = 44100.0f;
+    float smoothing = 0.005f;
+    float smoothingCoefficient = smoothing;
+    float mipLevel = 0.0f;
+    float maxRelease = 8.0f;
     std::vector<float> lfoSmoothed;
     std::vector<float> scSmoothed;
     
-    float sampleRate;
-    float lfoRate;
+    //deterministic mode, detection runs on windows of the stream instead of host blocks so the block size doesn't matter
+    juce::int64 blockStartSample = 0;       //stream position of the current block since prepareToPlay
+    juce::int64 samplesProcessed = 0;
+    int levelWindowSize = 441;
+    int levelWindowFill = 0;
+    std::array<double, 2> levelWindowSums {};
+    //synced phase is derived from one anchor instead of every block's ppq, moved when the transport jumps or the tempo changes
+    double syncAnchorPpq = 0.0;
+    juce::int64 syncAnchorSample = -1;
+    double syncAnchorBeatsPerSample = 0.0;
+    
     Modulator modulator;
-    float depth = 1.0f;
-    float panOffset = 0.0f;
-    double phase = 0.0;
-    float smoothing = 0.005f;
-    float maxRelease = 8.0f;
+    std::array<Modulator, maxBands - 1> bandModulators;
+    ShapeCompiler shapeCompiler { { &modulator, &bandModulators[0], &bandModulators[1], &bandModulators[2] } };
+    
+    //audio rate modes, one oversampler per factor (1x, 2x, 4x, 8x) so switching never allocates
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 4> oversamplers;
+    juce::AudioBuffer<float> modulationBuffer;
+    int preparedBlockSize = 0;
+    int activeOversampler = -1;     //used for the last block, -1 after prepareToPlay or an LFO block
+    int reportedLatency = 0;        //last latency the audio thread asked for
+    std::atomic<int> pendingLatency { 0 };     //handed to the message thread, which tells the host
+    int currentNote = -1;
+    
+    //multiband, tables are taken once per block so the per sample loop doesn't touch the atomics
+    MultibandCrossover crossover;
+    int numBands = 1;
+    std::array<Modulator::TableReference, maxBands> bandTables;
+    std::array<std::atomic<float>*, maxBands> bandDepthParameters {};
+    std::array<std::atomic<float>*, maxBands> bandPhaseParameters {};
+    std::array<float, maxBands> bandDepths {};
+    std::array<float, maxBands> bandPhases {};
+    std::array<std::array<float, 2>, maxBands> bandSmoothed {};
+    
+    //filter destination, cutoff and its modulation range are positions on the filter's log axis
+    ModulatedFilter filter;
+    bool filterDestination = false;
+    float filterCutoffPosition = 0.5f;
+    float filterRange = 0.0f;
+    float filterResonance = 0.707f;
+    float filterResonanceMod = 0.0f;
+    float filterSmoothingCoefficient = 1.0f;
+    
+    //sidechain scrub mode, the follower output is the read position
+    float scrubEnvelope = 0.0f;
+    
+    //detection prefilter, filtered into its own buffer so the aux input stays untouched
+    SidechainFilter sidechainFilter;
+    juce::AudioBuffer<float> scFilterBuffer;
+    TransientDetector transientDetector;
+    
+    //modulation of the first channel per sample, sent out as CV and MIDI CC at the end of the block
+    //with several bands it is the one of band 0
+    std::vector<float> modulationOutput;
+    float lastModulationOutput = 0.0f;
+    int ccCountdown = 0;
+    int lastCcValue = -1;
+    
+    //one pole DC blocker after the waveshaper, asymmetric curves add offset
+    float dcCoefficient = 0.999f;
+    std::array<float, 2> dcLastInput {};
+    std::array<float, 2> dcLastOutput {};
 
 };
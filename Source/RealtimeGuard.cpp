@@ -0,0 +1,360 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+    Created: 18 Oct 2026 11:36:20pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+
+#if LFOTOOL_REALTIME_GUARD
+
+#if ! JUCE_LINUX
+ #error "The realtime guard interposes libc functions, it is only available on Linux"
+#endif
+
+#include <new>
+#include <cstdlib>
+#include <cstdarg>
+#include <cerrno>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+//glibc's own allocator entry points, the interposed functions and operator new forward to these directly,
+//going through dlsym would allocate on the way and std::malloc would land in the interposed malloc again
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* memory, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* memory);
+}
+
+namespace {
+
+//plain ints, these are read from inside malloc and have to work before any constructor ran
+//initial-exec so reading them never allocates a dynamic TLS block
+__attribute__((tls_model("initial-exec"))) thread_local int audioDepth = 0;
+__attribute__((tls_model("initial-exec"))) thread_local int allowDepth = 0;
+//set while check() runs, whatever it calls into is not checked again
+__attribute__((tls_model("initial-exec"))) thread_local bool checking = false;
+
+std::atomic<int> numViolations { 0 };
+
+//only touched while the reporting thread has itself allowed, so the bookkeeping can allocate and lock
+juce::CriticalSection& getViolationLock() {
+    static juce::CriticalSection lock;
+    return lock;
+}
+
+std::vector<RealtimeGuard::Violation>& getViolationList() {
+    static std::vector<RealtimeGuard::Violation> violations;
+    return violations;
+}
+
+bool isGuarded() {
+    return audioDepth > 0 && allowDepth == 0;
+}
+
+void report(const char* call) {
+    ///the first occurrence per call and stack is kept with its stack, repeats are only counted
+    ++numViolations;
+    const RealtimeGuard::ScopedAllow allow;
+    const auto stack = juce::SystemStats::getStackBacktrace();
+
+    const juce::ScopedLock sl(getViolationLock());
+    auto& violations = getViolationList();
+    for (auto& violation : violations) {
+        if (violation.call == call && violation.stack == stack) {
+            ++violation.count;
+            return;
+        }
+    }
+    violations.push_back({ call, stack, 1 });
+}
+
+void check(const char* call) {
+    if (checking || !isGuarded())
+        return;
+    checking = true;
+    report(call);
+    checking = false;
+}
+
+///looks up the next definition of a libc function, behind the one defined here
+///the result is cached in a plain pointer, a function local static would take a guard lock on first use
+template <typename Function>
+Function getNext(Function& cached, const char* name) {
+    if (cached == nullptr)
+        cached = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    return cached;
+}
+
+///the condition variable functions exist in two versions, plain dlsym returns the old one that doesn't match
+///the pthread_cond_t layout of the headers, so the current version is asked for by name where there is one
+template <typename Function>
+Function getNextCurrent(Function& cached, const char* name) {
+    if (cached == nullptr)
+        cached = reinterpret_cast<Function>(dlvsym(RTLD_NEXT, name, "GLIBC_2.3.2"));
+    return getNext(cached, name);
+}
+
+struct NextFunctions {
+    int (*mutexLock)(pthread_mutex_t*);
+    int (*mutexTryLock)(pthread_mutex_t*);
+    int (*readLock)(pthread_rwlock_t*);
+    int (*writeLock)(pthread_rwlock_t*);
+    int (*conditionWait)(pthread_cond_t*, pthread_mutex_t*);
+    int (*conditionTimedWait)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+    int (*semaphoreWait)(sem_t*);
+    int (*semaphoreTimedWait)(sem_t*, const struct timespec*);
+    ssize_t (*read)(int, void*, size_t);
+    ssize_t (*write)(int, const void*, size_t);
+    int (*open)(const char*, int, ...);
+    int (*close)(int);
+    int (*nanosleep)(const struct timespec*, struct timespec*);
+    int (*usleep)(useconds_t);
+    int (*schedYield)();
+};
+
+//zero initialized before anything runs
+NextFunctions next;
+
+} //namespace
+
+RealtimeGuard::ScopedAudioThread::ScopedAudioThread() { ++audioDepth; }
+RealtimeGuard::ScopedAudioThread::~ScopedAudioThread() { --audioDepth; }
+RealtimeGuard::ScopedAllow::ScopedAllow() { ++allowDepth; }
+RealtimeGuard::ScopedAllow::~ScopedAllow() { --allowDepth; }
+
+bool RealtimeGuard::isCompiledIn() {
+    return true;
+}
+
+int RealtimeGuard::getNumViolations() {
+    return numViolations.load();
+}
+
+std::vector<RealtimeGuard::Violation> RealtimeGuard::getViolations() {
+    const ScopedAllow allow;
+    const juce::ScopedLock sl(getViolationLock());
+    return getViolationList();
+}
+
+void RealtimeGuard::clearViolations() {
+    const ScopedAllow allow;
+    const juce::ScopedLock sl(getViolationLock());
+    getViolationList().clear();
+    numViolations = 0;
+}
+
+//==============================================================================
+//global operator new/delete, every variant so nothing slips past through an overload
+
+//these call glibc's allocator directly, through malloc every new would be reported twice
+
+void* operator new(std::size_t size) {
+    check("operator new");
+    if (auto* memory = __libc_malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    check("operator new[]");
+    if (auto* memory = __libc_malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    check("operator new");
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    check("operator new[]");
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    check("operator new");
+    if (auto* memory = __libc_memalign(juce::jmax(sizeof(void*), (std::size_t) alignment), size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr)
+        check("operator delete");
+    __libc_free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    if (memory != nullptr)
+        check("operator delete[]");
+    __libc_free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { operator delete[](memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { operator delete(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { operator delete[](memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { operator delete[](memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { operator delete[](memory); }
+
+//==============================================================================
+//libc functions that block or enter the kernel, defined in the executable they are found before libc's
+
+extern "C" {
+
+void* malloc(size_t size) {
+    check("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) {
+    check("realloc");
+    return __libc_realloc(memory, size);
+}
+
+void free(void* memory) {
+    if (memory != nullptr)
+        check("free");
+    __libc_free(memory);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size) {
+    check("posix_memalign");
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    *memory = __libc_memalign(alignment, size);
+    return *memory != nullptr ? 0 : ENOMEM;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    check("pthread_mutex_lock");
+    return getNext(next.mutexLock, "pthread_mutex_lock")(mutex);
+}
+
+//doesn't block, but code that tries a lock on the audio thread has a path that gives up, which is worth seeing
+int pthread_mutex_trylock(pthread_mutex_t* mutex) {
+    check("pthread_mutex_trylock");
+    return getNext(next.mutexTryLock, "pthread_mutex_trylock")(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) {
+    check("pthread_rwlock_rdlock");
+    return getNext(next.readLock, "pthread_rwlock_rdlock")(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) {
+    check("pthread_rwlock_wrlock");
+    return getNext(next.writeLock, "pthread_rwlock_wrlock")(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex) {
+    check("pthread_cond_wait");
+    return getNextCurrent(next.conditionWait, "pthread_cond_wait")(condition, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* timeout) {
+    check("pthread_cond_timedwait");
+    return getNextCurrent(next.conditionTimedWait, "pthread_cond_timedwait")(condition, mutex, timeout);
+}
+
+int sem_wait(sem_t* semaphore) {
+    check("sem_wait");
+    return getNext(next.semaphoreWait, "sem_wait")(semaphore);
+}
+
+int sem_timedwait(sem_t* semaphore, const struct timespec* timeout) {
+    check("sem_timedwait");
+    return getNext(next.semaphoreTimedWait, "sem_timedwait")(semaphore, timeout);
+}
+
+ssize_t read(int file, void* data, size_t size) {
+    check("read");
+    return getNext(next.read, "read")(file, data, size);
+}
+
+ssize_t write(int file, const void* data, size_t size) {
+    check("write");
+    return getNext(next.write, "write")(file, data, size);
+}
+
+int open(const char* path, int flags, ...) {
+    check("open");
+    mode_t mode = 0;
+    if ((flags & O_CREAT) != 0) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t) va_arg(args, int);
+        va_end(args);
+    }
+    return getNext(next.open, "open")(path, flags, mode);
+}
+
+int close(int file) {
+    check("close");
+    return getNext(next.close, "close")(file);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    check("nanosleep");
+    return getNext(next.nanosleep, "nanosleep")(duration, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+    check("usleep");
+    return getNext(next.usleep, "usleep")(microseconds);
+}
+
+int sched_yield() {
+    check("sched_yield");
+    return getNext(next.schedYield, "sched_yield")();
+}
+
+} //extern "C"
+
+#else
+
+RealtimeGuard::ScopedAudioThread::ScopedAudioThread() {}
+RealtimeGuard::ScopedAudioThread::~ScopedAudioThread() {}
+RealtimeGuard::ScopedAllow::ScopedAllow() {}
+RealtimeGuard::ScopedAllow::~ScopedAllow() {}
+
+bool RealtimeGuard::isCompiledIn() {
+    return false;
+}
+
+int RealtimeGuard::getNumViolations() {
+    return 0;
+}
+
+std::vector<RealtimeGuard::Violation> RealtimeGuard::getViolations() {
+    return {};
+}
+
+void RealtimeGuard::clearViolations() {}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+    Created: 18 Oct 2026 11:36:20pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+
+//debug and test builds of the tools turn this on, the plugin itself never does
+#ifndef LFOTOOL_REALTIME_GUARD
+ #define LFOTOOL_REALTIME_GUARD 0
+#endif
+
+
+///checks that the audio callback stays realtime safe
+///while a thread is inside an audio scope, heap allocation (operator new/delete and the malloc family), locking
+///(mutexes, rwlocks, condition variables, semaphores) and blocking system calls are intercepted and reported
+///together with the stack they came from
+///the interception replaces the global operator new/delete and interposes the libc functions,
+///so it only exists when LFOTOOL_REALTIME_GUARD is set and the scope macro is empty otherwise
+namespace RealtimeGuard {
+
+    struct Violation {
+        juce::String call;      //what was called, e.g. "operator new" or "pthread_mutex_lock"
+        juce::String stack;
+        int count = 0;          //how often this call came from this stack
+    };
+
+    ///marks the calling thread as an audio thread until the scope ends, scopes can nest
+    class ScopedAudioThread {
+    public:
+        ScopedAudioThread();
+        ~ScopedAudioThread();
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+    };
+
+    ///lets the calling thread through inside an audio scope, for work that is known not to be realtime (the harness)
+    class ScopedAllow {
+    public:
+        ScopedAllow();
+        ~ScopedAllow();
+        JUCE_DECLARE_NON_COPYABLE(ScopedAllow)
+    };
+
+    bool isCompiledIn();
+    int getNumViolations();
+    std::vector<Violation> getViolations();
+    void clearViolations();
+}
+
+#if LFOTOOL_REALTIME_GUARD
+ #define LFOTOOL_REALTIME_SCOPE const RealtimeGuard::ScopedAudioThread realtimeGuardScope;
+#else
+ #define LFOTOOL_REALTIME_SCOPE
+#endif
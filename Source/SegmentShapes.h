@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    SegmentShapes.h
+    Created: 19 Oct 2026 9:14:20am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>
+#include <algorithm>
+
+
+///how an edge gets from one node to the next
+enum class SegmentType {
+    Curve,          //quadratic bezier through the handle, the original behaviour
+    Hold,           //stays at the left node and jumps to the right one at the end
+    Linear,
+    Exponential,    //the handle sets the tension
+    Cubic,          //cubic bezier with both inner control points on the handle
+    SCurve          //the handle sets the steepness
+};
+
+namespace SegmentShapes {
+    
+    constexpr int numTypes = 6;
+    
+    inline const char* getName(SegmentType type) {
+        switch (type) {
+            case SegmentType::Curve:        return "Curve";
+            case SegmentType::Hold:         return "Hold";
+            case SegmentType::Linear:       return "Linear";
+            case SegmentType::Exponential:  return "Exponential";
+            case SegmentType::Cubic:        return "Cubic";
+            case SegmentType::SCurve:       return "S-Curve";
+        }
+        return "";
+    }
+    
+    ///tension in -1..1 from where the handle sits between the start and end value,
+    ///positive means the handle leans towards the end value, works for any affine mapping of y
+    inline float tensionFromHandle(float y0, float y1, float y2) {
+        float range = y2 - y0;
+        if (std::abs(range) < 1e-4f)
+            return 0.0f;
+        float tension = (2.0f * y1 - y0 - y2) / range;
+        return std::clamp(tension, -1.0f, 1.0f);
+    }
+    
+    ///closed form value of a segment at alpha in 0..1
+    inline float evaluate(SegmentType type, float y0, float y1, float y2, float tension, float alpha) {
+        switch (type) {
+            case SegmentType::Hold:
+                return alpha < 1.0f ? y0 : y2;
+                
+            case SegmentType::Linear:
+                return y0 + (y2 - y0) * alpha;
+                
+            case SegmentType::Exponential: {
+                float k = -8.0f * tension;
+                if (std::abs(k) < 1e-3f)
+                    return y0 + (y2 - y0) * alpha;
+                float shape = (std::exp(k * alpha) - 1.0f) / (std::exp(k) - 1.0f);
+                return y0 + (y2 - y0) * shape;
+            }
+                
+            case SegmentType::Cubic: {
+                float inv = 1.0f - alpha;
+                return inv * inv * inv * y0
+                     + 3.0f * inv * alpha * y1
+                     + alpha * alpha * alpha * y2;
+            }
+                
+            case SegmentType::SCurve: {
+                float power = std::exp2(3.0f * tension);
+                float a = std::pow(alpha, power);
+                float b = std::pow(1.0f - alpha, power);
+                float shape = a + b > 0.0f ? a / (a + b) : alpha;
+                return y0 + (y2 - y0) * shape;
+            }
+                
+            case SegmentType::Curve:
+            default:
+                return (1 - alpha) * (1 - alpha) * y0
+                     + 2 * (1 - alpha) * alpha * y1
+                     + alpha * alpha * y2;
+        }
+    }
+}
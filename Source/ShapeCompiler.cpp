@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    ShapeCompiler.cpp
+    Created: 18 Oct 2026 1:47:05pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "ShapeCompiler.h"
+#include "TraceRecorder.h"
+
+ShapeCompiler::SharedThread::SharedThread() : juce::Thread("Shape Compiler") {
+    startThread(juce::Thread::Priority::low);
+}
+
+ShapeCompiler::SharedThread::~SharedThread() {
+    stopThread(1000);
+}
+
+void ShapeCompiler::SharedThread::add(ShapeCompiler* compiler) {
+    const juce::ScopedLock sl(listLock);
+    compilers.addIfNotAlreadyThere(compiler);
+}
+
+void ShapeCompiler::SharedThread::remove(ShapeCompiler* compiler) {
+    const juce::ScopedLock sl(listLock);
+    compilers.removeFirstMatchingValue(compiler);
+}
+
+void ShapeCompiler::SharedThread::run() {
+    LFOTOOL_TRACE_THREAD("Shape Compiler")
+    ///a notify that arrives while compiling leaves the event signalled, so the next wait returns right away
+    while (!threadShouldExit()) {
+        bool retry = false;
+        {
+            const juce::ScopedLock sl(listLock);
+            for (auto* compiler : compilers) {
+                if (threadShouldExit())
+                    break;
+                if (!compiler->compilePending())
+                    retry = true;
+            }
+        }
+        
+        //some compiler had every table in use, try again shortly
+        wait(retry ? 1 : -1);
+    }
+}
+
+ShapeCompiler::ShapeCompiler(std::vector<Modulator*> targets)
+    : targets(std::move(targets)), pending(this->targets.size()),
+      fft(juce::roundToInt(std::log2(this->targets.front()->getResolution()))) {
+    ///all targets have to use the same resolution, the pooled tables are shared between them
+    const int resolution = this->targets.front()->getResolution();
+    spectrum.resize(2 * resolution, 0.0f);
+    scratch.resize(2 * resolution, 0.0f);
+    tablePool.resize(this->targets.size() * tablesPerTarget + cachedTables);
+    
+    sharedThread->add(this);
+}
+
+ShapeCompiler::~ShapeCompiler() {
+    sharedThread->remove(this);
+}
+
+void ShapeCompiler::submit(std::vector<ModulationSegment> segments, int target) {
+    ///called from the message thread, replaces whatever is still waiting for this target
+    if (segments.empty() || !juce::isPositiveAndBelow(target, (int) targets.size()))
+        return;
+    
+    if (publishCached(hashSegments(segments), target)) {
+        //a pending older edit must not overwrite the cached table
+        const juce::ScopedLock sl(pendingLock);
+        pending[target].hasPending = false;
+        return;
+    }
+    
+    {
+        const juce::ScopedLock sl(pendingLock);
+        pending[target].segments = std::move(segments);
+        pending[target].hasPending = true;
+    }
+    sharedThread->notify();
+}
+
+void ShapeCompiler::compileNow(const std::vector<ModulationSegment>& segments, int target) {
+    ///synchronous compile, used when restoring state so the first block already has the right shape
+    if (segments.empty() || !juce::isPositiveAndBelow(target, (int) targets.size()))
+        return;
+    
+    {
+        //a pending edit is older than this one
+        const juce::ScopedLock sl(pendingLock);
+        pending[target].hasPending = false;
+    }
+    
+    if (!compile(segments, target)) {
+        auto& modulator = *targets[(size_t) target];
+        auto values = std::make_shared<ModulationTable>(modulator.getResolution());
+        const juce::ScopedLock sl(compileLock);
+        modulator.fillModulationValues(segments, *values);
+        modulator.buildMipLevels(*values, fft, spectrum, scratch);
+        modulator.publishModulationValues(values);
+    }
+}
+
+bool ShapeCompiler::compilePending() {
+    ///runs on the shared thread, returns false if a shape had to be put back because every table is still in use
+    for (;;) {
+        const int target = takePending();
+        if (target < 0)
+            return true;
+        
+        if (!compile(workingSegments, target)) {
+            //put the shape back unless a newer one arrived
+            const juce::ScopedLock sl(pendingLock);
+            if (!pending[target].hasPending) {
+                std::swap(workingSegments, pending[target].segments);
+                pending[target].hasPending = true;
+            }
+            return false;
+        }
+    }
+}
+
+int ShapeCompiler::takePending() {
+    ///moves the next waiting shape into workingSegments and returns its target, -1 if nothing is waiting
+    const juce::ScopedLock sl(pendingLock);
+    for (size_t target = 0; target < pending.size(); ++target) {
+        if (pending[target].hasPending) {
+            std::swap(workingSegments, pending[target].segments);
+            pending[target].hasPending = false;
+            return (int) target;
+        }
+    }
+    return -1;
+}
+
+bool ShapeCompiler::compile(const std::vector<ModulationSegment>& segments, int target) {
+    LFOTOOL_TRACE_SCOPE("ShapeCompiler::compile")
+    const juce::ScopedLock sl(compileLock);
+    
+    const auto hash = hashSegments(segments);
+    if (publishCached(hash, target))
+        return true;
+    
+    auto& modulator = *targets[(size_t) target];    
+    auto* table = getFreeTable();
+    if (table == nullptr)
+        return false;
+    
+    table->hash = 0;
+    modulator.fillModulationValues(segments, *table->values);
+    modulator.buildMipLevels(*table->values, fft, spectrum, scratch);
+    table->hash = hash;
+    table->lastUsed = ++useCounter;
+    modulator.publishModulationValues(table->values);
+    return true;
+}
+
+bool ShapeCompiler::publishCached(juce::uint64 hash, int target) {
+    ///republish a table that was already built from the same shape, for any band
+    const juce::ScopedLock sl(compileLock);
+    for (auto& table : tablePool) {
+        if (table.hash == hash) {
+            table.lastUsed = ++useCounter;
+            targets[(size_t) target]->publishModulationValues(table.values);
+            return true;
+        }
+    }
+    return false;
+}
+
+ShapeCompiler::PooledTable* ShapeCompiler::getFreeTable() {
+    ///a table is free when the pool holds the only reference,
+    ///i.e. it is neither published in any modulator nor still read by the audio thread
+    ///the pool keeps ownership, so the audio thread never frees a table
+    ///of the free ones, the least recently used is overwritten so recent shapes stay cached
+    ///entries that were never used get their table here, off the audio thread
+    for (auto* target : targets)
+        target->releaseRetiredTables();
+    
+    PooledTable* oldest = nullptr;
+    for (auto& table : tablePool) {
+        if (table.values == nullptr) {
+            table.values = std::make_shared<ModulationTable>(targets.front()->getResolution(), 1.0f);
+            return &table;
+        }
+        if (table.values.use_count() == 1 && (oldest == nullptr || table.lastUsed < oldest->lastUsed))
+            oldest = &table;
+    }
+    return oldest;
+}
+
+juce::uint64 ShapeCompiler::hashSegments(const std::vector<ModulationSegment>& segments) {
+    ///FNV-1a over the raw segment data
+    juce::uint64 hash = 14695981039346656037ull;
+    const auto* bytes = reinterpret_cast<const juce::uint8*>(segments.data());
+    const size_t numBytes = segments.size() * sizeof(ModulationSegment);
+    for (size_t i = 0; i < numBytes; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
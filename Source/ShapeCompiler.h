@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ShapeCompiler.h
+    Created: 18 Oct 2026 1:47:05pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include "Modulator.h"
+
+
+///turns shape edits into modulation tables on a low priority background thread
+///bursts of edits are coalesced, only the latest submitted shape gets compiled
+///tables come from a pool and are handed to the modulator when done, pool tables are allocated on first use
+///the pool remembers which shape each table was built from, so going back to a recent shape (undo) needs no compile
+///one compiler serves several modulators (one per band), they share the pool and the cache
+///all compilers of the process share one background thread, so a session with hundreds of instances
+///doesn't keep hundreds of mostly idle threads around
+class ShapeCompiler {
+    
+private:
+    
+    ///the thread every compiler hands its pending shapes to, alive as long as any compiler is
+    class SharedThread : public juce::Thread {
+    public:
+        SharedThread();
+        ~SharedThread() override;
+        
+        void add(ShapeCompiler* compiler);
+        void remove(ShapeCompiler* compiler);
+        
+    private:
+        juce::CriticalSection listLock;     //held while compiling, so remove() waits for a running compile
+        juce::Array<ShapeCompiler*> compilers;
+        
+        void run() override;
+    };
+    
+    //a table with all its mip levels is around 90 KB, so the pool only covers what the bands need:
+    //the published table and one that the audio thread may still be reading, plus a few recent shapes for undo
+    static constexpr int tablesPerTarget = 2;
+    static constexpr int cachedTables = 2;
+    
+    struct PooledTable {
+        std::shared_ptr<ModulationTable> values;
+        juce::uint64 hash = 0;      //0 while the table doesn't hold a finished shape
+        juce::uint32 lastUsed = 0;
+    };
+    
+    struct Pending {
+        std::vector<ModulationSegment> segments;
+        bool hasPending = false;
+    };
+    
+    std::vector<Modulator*> targets;
+    
+    juce::CriticalSection pendingLock;
+    std::vector<Pending> pending;
+    std::vector<ModulationSegment> workingSegments;
+    
+    juce::CriticalSection compileLock;
+    std::vector<PooledTable> tablePool;
+    juce::uint32 useCounter = 0;
+    
+    //used by compile() under compileLock
+    juce::dsp::FFT fft;
+    std::vector<float> spectrum;
+    std::vector<float> scratch;
+    
+    juce::SharedResourcePointer<SharedThread> sharedThread;
+    
+    bool compilePending();
+    bool compile(const std::vector<ModulationSegment>& segments, int target);
+    bool publishCached(juce::uint64 hash, int target);
+    int takePending();
+    PooledTable* getFreeTable();
+    static juce::uint64 hashSegments(const std::vector<ModulationSegment>& segments);
+    
+public:
+    
+    explicit ShapeCompiler(std::vector<Modulator*> targets);
+    ~ShapeCompiler();
+    
+    void submit(std::vector<ModulationSegment> segments, int target = 0);
+    void compileNow(const std::vector<ModulationSegment>& segments, int target = 0);
+};
@@ -23,6 +23,7 @@ ShapeGraph::ShapeGraph() {
 
 
 void ShapeGraph::addNode(juce::Point<float> position, bool isCornerNode) {
+    markChanged();
     //add new node
     float x = position.getX()-nodeSize/2;
     float y = position.getY()-nodeSize/2;
@@ -66,6 +67,7 @@ void ShapeGraph::shiftEdgeIndexes(int leftAnchorNode) {
 
 void ShapeGraph::moveNode(int index, juce::Point<float> position) {
     ///move Node with index to parsed position, prevent overlap with other nodes
+    markChanged();
     
     int y = position.getY();
     int x = 0;
@@ -123,6 +125,7 @@ void ShapeGraph::updateEdge(int edgeIndex) {
 void ShapeGraph::removeNode(int nodeIndex) {
     ///remove node with index
     if(nodeIndex > 0 && nodeIndex < nodes.size()-1) {
+        markChanged();
         nodes.remove(nodeIndex);
         removeEdge(nodeIndex-1);
         shiftEdgeIndexes(nodeIndex-1);
@@ -155,6 +158,7 @@ void ShapeGraph::moveEdge(int index, juce::Point<float> position) {
     //std::cout << "Moving edge" << std::endl;
     ///move edge with index to parsed position
     /// Ensure the node stays within its allowed space
+    markChanged();
     ShapeEdge& edge = *edges[index];
     
     int from = edge.from;
@@ -187,6 +191,7 @@ void ShapeGraph::removeEdge(int leftAnchorNode) {
 
 void ShapeGraph::resetEdgeCurve(int leftAnchorNode) {
     ///reset edge with index leftAnchorNode
+    markChanged();
     ShapeEdge& edge = *edges[leftAnchorNode];
     int midX = calcEdgeMidX(edge.from);
     int midY = calcEdgeMidY(edge.from);
@@ -195,6 +200,74 @@ void ShapeGraph::resetEdgeCurve(int leftAnchorNode) {
     edge.yDeviation = 0;
 }
 
+void ShapeGraph::setEdgeControlY(int index, float centreY) {
+    ///bend edge with index so its control point sits at centreY, horizontally centred between its nodes
+    markChanged();
+    ShapeEdge& edge = *edges[index];
+    edge.xDeviation = 0;
+    edge.yDeviation = centreY - nodeSize/2 - calcEdgeMidY(edge.from);
+    updateEdge(index);
+}
+
+void ShapeGraph::setEdgeType(int index, SegmentType type) {
+    if(index < 0 || index >= edges.size())
+        return;
+    markChanged();
+    edges[index]->type = type;
+}
+
+void ShapeGraph::insertCurve(const std::vector<juce::Point<float>>& nodeCentres, const std::vector<float>& controlYs) {
+    ///replace everything between the first and the last centre with new nodes,
+    ///controlYs holds one control point per gap between consecutive centres
+    if(nodeCentres.size() < 2)
+        return;
+    
+    markChanged();
+    clearSelection();
+    const float startX = nodeCentres.front().getX();
+    const float endX = nodeCentres.back().getX();
+    
+    //remove the inner nodes the curve is drawn over
+    for(int i = nodes.size()-2; i > 0; --i) {
+        float centreX = nodes[i]->rect.getCentreX();
+        if(centreX >= startX && centreX <= endX)
+            removeNode(i);
+    }
+    
+    //centres on top of a corner node move the corner instead of adding a node next to it
+    std::vector<int> nodeIndexes;
+    for(const auto& centre : nodeCentres) {
+        const int last = nodes.size()-1;
+        if(std::abs(centre.getX() - nodes[0]->rect.getCentreX()) < 1.0f) {
+            moveNode(0, centre - juce::Point<float>(nodeSize/2, nodeSize/2));
+        } else if(std::abs(centre.getX() - nodes[last]->rect.getCentreX()) < 1.0f) {
+            moveNode(last, centre - juce::Point<float>(nodeSize/2, nodeSize/2));
+        } else {
+            addNode(centre, false);
+        }
+    }
+    
+    //nodes are sorted by x, look the new ones up again to bend the edges between them
+    for(const auto& centre : nodeCentres) {
+        int index = 0;
+        float closest = std::numeric_limits<float>::max();
+        for(int i = 0; i < nodes.size(); ++i) {
+            float distance = std::abs(nodes[i]->rect.getCentreX() - centre.getX());
+            if(distance < closest) {
+                closest = distance;
+                index = i;
+            }
+        }
+        nodeIndexes.push_back(index);
+    }
+    
+    for(size_t i = 0; i + 1 < nodeIndexes.size() && i < controlYs.size(); ++i) {
+        if(nodeIndexes[i+1] == nodeIndexes[i]+1)
+            setEdgeControlY(nodeIndexes[i], controlYs[i]);
+    }
+    clearSelection();
+}
+
 float ShapeGraph::calcEdgeMidX(int from)   {
     return (nodes[from]->rect.getCentreX() + nodes[from+1]->rect.getCentreX() - nodeSize) / 2;
 }
@@ -233,6 +306,7 @@ std::pair<int, juce::Rectangle<float>*> ShapeGraph::containsPointOnEdge(juce::Po
 void ShapeGraph::quantizeNode (int index)    {
     //if no rectangle is being edited, return, should never happen
     if(index < 0) return;
+    markChanged();
     
     ShapeNode& node = *nodes[index];
     float nodeX = node.rect.getX();
@@ -257,11 +331,16 @@ void ShapeGraph::quantizeNode() {
 void ShapeGraph::resizeNodeLayout()  {
     ///called when window size changes
     ///update the position of the corner nodes, later on the other nodes will be updated, priority very low
+    markChanged();
     nodes[0]->rect.setPosition(leftBound-nodeSize/2, bottomBound-nodeSize);
     nodes[nodes.size()-1]->rect.setPosition(rightBound-nodeSize/2, topBound);
-    //recreate all edges
-    for (int i = 0; i < nodes.size()-1; ++i) {
-        addEdge(i);
+    //create the edges if they don't match the nodes yet, otherwise move them along with their nodes
+    if(edges.size() != nodes.size()-1) {
+        makeEdgesFromScratch();
+    } else {
+        for (int i = 0; i < edges.size(); ++i) {
+            updateEdge(i);
+        }
     }
     
     //clear previous quantization steps
@@ -283,8 +362,37 @@ void ShapeGraph::paint(juce::Graphics& g)   {
     path.clear();
     for(int i = 0; i < edges.size(); ++i) {
         //draw edges
-        path.startNewSubPath(nodes[edges[i]->from]->rect.getCentre().toFloat());
-        path.quadraticTo(edges[i]->rect.getCentre().toFloat(), nodes[edges[i]->to]->rect.getCentre().toFloat());
+        auto start = nodes[edges[i]->from]->rect.getCentre().toFloat();
+        auto handle = edges[i]->rect.getCentre().toFloat();
+        auto end = nodes[edges[i]->to]->rect.getCentre().toFloat();
+        path.startNewSubPath(start);
+        
+        switch(edges[i]->type) {
+            case SegmentType::Curve:
+                path.quadraticTo(handle, end);
+                break;
+            case SegmentType::Cubic:
+                path.cubicTo(handle, handle, end);
+                break;
+            case SegmentType::Hold:
+                path.lineTo(end.getX(), start.getY());
+                path.lineTo(end);
+                break;
+            case SegmentType::Linear:
+                path.lineTo(end);
+                break;
+            default: {
+                //no path primitive for these, sample the same function the modulator uses
+                const int numSteps = 32;
+                float tension = SegmentShapes::tensionFromHandle(start.getY(), handle.getY(), end.getY());
+                for(int step = 1; step <= numSteps; ++step) {
+                    float alpha = (float) step / numSteps;
+                    float y = SegmentShapes::evaluate(edges[i]->type, start.getY(), handle.getY(), end.getY(), tension, alpha);
+                    path.lineTo(start.getX() + alpha * (end.getX() - start.getX()), y);
+                }
+                break;
+            }
+        }
         g.strokePath(path, juce::PathStrokeType(2.0f));
         g.drawEllipse(edges[i]->rect.toFloat(), 2.0f);
     }
@@ -322,6 +430,14 @@ int ShapeGraph::getSelectedIndex()  {
     return selectedIndex;
 }
 
+juce::uint32 ShapeGraph::getVersion() const {
+    return version;
+}
+
+void ShapeGraph::markChanged() {
+    ++version;
+}
+
 void ShapeGraph::setHeight(int frameHeight)  {
     height = frameHeight;
 }
@@ -389,6 +505,7 @@ std::unique_ptr<juce::XmlElement> ShapeGraph::createXML() {
         edgeXml->setAttribute("to", edge->to);
         edgeXml->setAttribute("xDeviation", edge->xDeviation);
         edgeXml->setAttribute("yDeviation", edge->yDeviation);
+        edgeXml->setAttribute("type", (int) edge->type);
     }
     
     return xml;
@@ -396,6 +513,7 @@ std::unique_ptr<juce::XmlElement> ShapeGraph::createXML() {
 
 void ShapeGraph::loadXML(juce::XmlElement& xml)
 {
+    markChanged();
     nodes.clear();
     edges.clear();
     
@@ -404,34 +522,135 @@ void ShapeGraph::loadXML(juce::XmlElement& xml)
     {
         if (child->hasTagName("Node"))
         {
-            float x = child->getDoubleAttribute("x");
-            float y = child->getDoubleAttribute("y");
-            addNode({ x + nodeSize / 2.0f, y + nodeSize / 2.0f }, true);
+            if (nodes.size() >= maxNodes)
+                break;
+            
+            //anything that isn't a finite position near the layout would break the sort and the int edge math
+            const double x = child->getDoubleAttribute("x");
+            const double y = child->getDoubleAttribute("y");
+            if (!(std::abs(x) <= maxCoordinate && std::abs(y) <= maxCoordinate))
+                continue;
+            addNode({ (float) x + nodeSize / 2.0f, (float) y + nodeSize / 2.0f }, true);
         }
     }
     
     
+    //without both corners there is no shape, fall back to the default one the constructor makes
+    if (nodes.size() < 2) {
+        nodes.clear();
+        addNode(juce::Point<float>(0, 0), true);
+        addNode(juce::Point<float>(1, 1), true);
+        //a graph that was never laid out stays without extent, so nothing gets compiled from it
+        if (width > 0 && height > 0)
+            resizeNodeLayout();
+        else
+            makeEdgesFromScratch();
+        return;
+    }
+    
     // Set corner node positions correctly (you already reposition in resizeNodeLayout anyway)
     nodes.sort(comparator);
     
-    // Load all edges
+    //positions are saved in pixels of the layout they were drawn in, map them into the current one
+    float xScale = 1.0f;
+    float yScale = 1.0f;
+    if (width <= 0 || height <= 0) {
+        //a graph that was never laid out (restored without an editor) takes its bounds from the saved corners
+        deriveBoundsFromCorners();
+    } else {
+        const int currentLeft = leftBound, currentRight = rightBound, currentTop = topBound, currentBottom = bottomBound;
+        const int currentWidth = width, currentHeight = height;
+        deriveBoundsFromCorners();
+        const int savedLeft = leftBound, savedTop = topBound;
+        const int savedWidth = width, savedHeight = height;
+        leftBound = currentLeft;
+        rightBound = currentRight;
+        topBound = currentTop;
+        bottomBound = currentBottom;
+        width = currentWidth;
+        height = currentHeight;
+        
+        //node centres span x from left to right, node rects y from top to bottom-nodeSize, see resizeNodeLayout
+        if (savedWidth > 0 && savedHeight > nodeSize) {
+            xScale = (float) width / savedWidth;
+            yScale = (height - nodeSize) / (savedHeight - nodeSize);
+            for (auto* node : nodes) {
+                node->rect.setPosition(leftBound + (node->rect.getCentreX() - savedLeft) * xScale - nodeSize/2,
+                                       topBound + (node->rect.getY() - savedTop) * yScale);
+            }
+        }
+    }
+    
+    // Load all edges, older versions could save the same edge more than once
+    std::vector<bool> edgeLoaded(nodes.size(), false);
     for (auto* child : xml.getChildIterator())
     {
         if (child->hasTagName("Edge"))
         {
             int from = child->getIntAttribute("from");
+            if (from < 0 || from >= nodes.size()-1 || edgeLoaded[from])
+                continue;
+            edgeLoaded[from] = true;
             //int to = child->getIntAttribute("to");
-            float xDev = child->getDoubleAttribute("xDeviation");
-            float yDev = child->getDoubleAttribute("yDeviation");
+            double xDev = child->getDoubleAttribute("xDeviation");
+            double yDev = child->getDoubleAttribute("yDeviation");
+            if (!(std::abs(xDev) <= maxCoordinate && std::abs(yDev) <= maxCoordinate))
+                xDev = yDev = 0.0;
+            xDev *= xScale;
+            yDev *= yScale;
             
             int midX = calcEdgeMidX(from);
             int midY = calcEdgeMidY(from);
             
-            auto* edge = new ShapeEdge({ midX + xDev, midY + yDev, nodeSize, nodeSize}, from, xDev, yDev);
+            auto* edge = new ShapeEdge({ midX + (float) xDev, midY + (float) yDev, nodeSize, nodeSize}, from, (float) xDev, (float) yDev);
+            edge->type = (SegmentType) juce::jlimit(0, SegmentShapes::numTypes - 1, child->getIntAttribute("type", 0));
             edges.add(edge);
         }
     }
+    
+    // add straight edges for whatever was missing
+    for (int i = 0; i < nodes.size()-1; ++i) {
+        if (!edgeLoaded[i])
+            addEdge(i);
+    }
+    edges.sort(edgeComparator);
 
 }
 
-
+void ShapeGraph::deriveBoundsFromCorners() {
+    ///inverse of the corner placement in resizeNodeLayout
+    if (nodes.size() < 2)
+        return;
+    
+    const auto& first = nodes[0]->rect;
+    const auto& last = nodes[nodes.size()-1]->rect;
+    leftBound = juce::roundToInt(first.getX() + nodeSize/2);
+    bottomBound = juce::roundToInt(first.getY() + nodeSize);
+    rightBound = juce::roundToInt(last.getX() + nodeSize/2);
+    topBound = juce::roundToInt(last.getY());
+    width = rightBound - leftBound;
+    height = bottomBound - topBound;
+}
+
+void ShapeGraph::restoreLayout(const std::vector<juce::Point<float>>& nodePositions, const std::vector<juce::Point<float>>& edgeDeviations,
+                               const std::vector<SegmentType>& edgeTypes) {
+    ///rebuild nodes and edges from plain positions, used by the undo history
+    ///nodePositions are the top left corners of the node rects, edgeDeviations has one entry per edge
+    markChanged();
+    clearSelection();
+    nodes.clear();
+    edges.clear();
+    
+    for (const auto& position : nodePositions) {
+        nodes.add(new ShapeNode(juce::Rectangle<float>(position.getX(), position.getY(), nodeSize, nodeSize), nodes.size()));
+    }
+    
+    for (int i = 0; i < nodes.size()-1 && i < (int) edgeDeviations.size(); ++i) {
+        float xDev = edgeDeviations[i].getX();
+        float yDev = edgeDeviations[i].getY();
+        auto* edge = new ShapeEdge({ calcEdgeMidX(i) + xDev, calcEdgeMidY(i) + yDev, nodeSize, nodeSize }, i, xDev, yDev);
+        if(i < (int) edgeTypes.size())
+            edge->type = edgeTypes[i];
+        edges.add(edge);
+    }
+}
@@ -11,6 +11,7 @@
 #pragma once
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_data_structures/juce_data_structures.h> 
+#include "SegmentShapes.h"
 
 struct ShapeNode {
     juce::Rectangle<float> rect;
@@ -24,13 +25,16 @@ struct ShapeEdge {
     int to;
     float xDeviation;
     float yDeviation;
+    SegmentType type = SegmentType::Curve;
     
     ShapeEdge(juce::Rectangle<float> rect, int from, float x, float y) : rect(rect), from(from), to(from+1), xDeviation(x), yDeviation(y) {}
 };
 
 struct NodeComparator {
     static int compareElements(ShapeNode* node1, ShapeNode* node2) {
-        return node1->rect.getX() - node2->rect.getX();
+        //compared, not subtracted, the int conversion made nodes less than a pixel apart compare inconsistently
+        const float x1 = node1->rect.getX(), x2 = node2->rect.getX();
+        return x1 < x2 ? -1 : (x2 < x1 ? 1 : 0);
     }
 };
 
@@ -50,17 +54,23 @@ private:
     const NodeComparator comparator;
     const EdgeComparator edgeComparator;
     
-    int height;
-    int width;
+    //stay 0 until the editor lays the graph out
+    int height = 0;
+    int width = 0;
     const float nodeSize = 10;
     
-    int leftBound;
-    int rightBound;
-    int topBound;
-    int bottomBound;
+    int leftBound = 0;
+    int rightBound = 0;
+    int topBound = 0;
+    int bottomBound = 0;
     
     int selectedIndex = -1;
     
+    //incremented on every edit, lets the editor skip work when nothing changed
+    juce::uint32 version = 0;
+    void markChanged();
+    void deriveBoundsFromCorners();
+    
     //quantization variables
     int quantizeDepth;
     juce::Array<int> widthQuantizationSteps;
@@ -79,6 +89,10 @@ public:
     juce::OwnedArray<ShapeNode> nodes;
     juce::OwnedArray<ShapeEdge> edges;
     
+    //limits for graphs loaded from saved data, so a corrupted or hostile session still loads in bounded time
+    static constexpr int maxNodes = 4096;
+    static constexpr double maxCoordinate = 1.0e6;
+    
     enum class SelectionType {Node, Edge, none};
     
     SelectionType selectionType = SelectionType::none;
@@ -97,6 +111,9 @@ public:
     void moveEdge(int index, juce::Point<float> position);
     void moveEdge(juce::Point<float> position);
     void resetEdgeCurve(int leftAnchorNode);
+    void setEdgeControlY(int index, float centreY);
+    void setEdgeType(int index, SegmentType type);
+    void insertCurve(const std::vector<juce::Point<float>>& nodeCentres, const std::vector<float>& controlYs);
     
     std::pair<int, juce::Rectangle<float>*> containsPointOnNode(juce::Point<float> point);
     std::pair<int, juce::Rectangle<float>*> containsPointOnEdge(juce::Point<float> point);
@@ -107,6 +124,7 @@ public:
     void selectEdge(int index);
     void clearSelection();
     int getSelectedIndex();
+    juce::uint32 getVersion() const;
     
     void setHeight(int height);
     int getHeight();
@@ -126,6 +144,8 @@ public:
     
     std::unique_ptr<juce::XmlElement> createXML();
     void loadXML(juce::XmlElement& xml);
+    void restoreLayout(const std::vector<juce::Point<float>>& nodePositions, const std::vector<juce::Point<float>>& edgeDeviations,
+                       const std::vector<SegmentType>& edgeTypes);
     
 };
 
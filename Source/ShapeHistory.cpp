@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    ShapeHistory.cpp
+    Created: 18 Oct 2026 3:05:52pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "ShapeHistory.h"
+
+void ShapeHistory::reset(const ShapeGraph& graph) {
+    ///forget everything and start from the current state of the graph
+    undoStack.clear();
+    redoStack.clear();
+    undoStack.push_back(capture(graph, nullptr));
+}
+
+bool ShapeHistory::push(const ShapeGraph& graph) {
+    ///store the current state of the graph, returns false if nothing changed since the last step
+    if (undoStack.empty()) {
+        reset(graph);
+        return true;
+    }
+    
+    auto snapshot = capture(graph, undoStack.back());
+    if (snapshot == undoStack.back())
+        return false;
+    
+    undoStack.push_back(snapshot);
+    redoStack.clear();
+    
+    //drop the oldest steps, chunks they shared with newer steps stay alive
+    while ((int) undoStack.size() > maxSteps)
+        undoStack.pop_front();
+    
+    return true;
+}
+
+bool ShapeHistory::undo(ShapeGraph& graph) {
+    if (!canUndo())
+        return false;
+    
+    redoStack.push_back(undoStack.back());
+    undoStack.pop_back();
+    restore(*undoStack.back(), graph);
+    return true;
+}
+
+bool ShapeHistory::redo(ShapeGraph& graph) {
+    if (!canRedo())
+        return false;
+    
+    undoStack.push_back(redoStack.back());
+    redoStack.pop_back();
+    restore(*undoStack.back(), graph);
+    return true;
+}
+
+bool ShapeHistory::canUndo() const {
+    return undoStack.size() > 1;
+}
+
+bool ShapeHistory::canRedo() const {
+    return !redoStack.empty();
+}
+
+std::shared_ptr<const ShapeSnapshot> ShapeHistory::capture(const ShapeGraph& graph, const std::shared_ptr<const ShapeSnapshot>& previous) {
+    ///flatten the graph, then share the unchanged chunks at the front and the back of the previous snapshot
+    ///only the nodes in between get new chunks, so inserting or moving a node costs about one chunk
+    current.clear();
+    for (int i = 0; i < graph.nodes.size(); ++i) {
+        const auto& rect = graph.nodes[i]->rect;
+        float xDeviation = 0.0f;
+        float yDeviation = 0.0f;
+        SegmentType type = SegmentType::Curve;
+        if (i < graph.edges.size()) {
+            xDeviation = graph.edges[i]->xDeviation;
+            yDeviation = graph.edges[i]->yDeviation;
+            type = graph.edges[i]->type;
+        }
+        current.push_back({ rect.getX(), rect.getY(), xDeviation, yDeviation, type });
+    }
+    
+    const int numNodes = (int) current.size();
+    auto snapshot = std::make_shared<ShapeSnapshot>();
+    snapshot->numNodes = numNodes;
+    
+    if (previous == nullptr) {
+        appendChunks(*snapshot, 0, numNodes);
+        return snapshot;
+    }
+    
+    const auto& oldChunks = previous->chunks;
+    const int numOldChunks = (int) oldChunks.size();
+    
+    auto chunkMatches = [this, numNodes](const ShapeSnapshot::Chunk& chunk, int offset) {
+        if (offset < 0 || offset + (int) chunk.size() > numNodes)
+            return false;
+        return std::equal(chunk.begin(), chunk.end(), current.begin() + offset);
+    };
+    
+    //unchanged chunks at the front
+    int front = 0;
+    int frontEnd = 0;
+    while (front < numOldChunks && chunkMatches(*oldChunks[front], frontEnd)) {
+        frontEnd += (int) oldChunks[front]->size();
+        ++front;
+    }
+    
+    if (front == numOldChunks && frontEnd == numNodes)
+        return previous;
+    
+    //unchanged chunks at the back, aligned to the end so inserts and removals keep them shared
+    int back = numOldChunks;
+    int backStart = numNodes;
+    while (back > front && chunkMatches(*oldChunks[back - 1], backStart - (int) oldChunks[back - 1]->size())
+           && backStart - (int) oldChunks[back - 1]->size() >= frontEnd) {
+        --back;
+        backStart -= (int) oldChunks[back]->size();
+    }
+    
+    snapshot->chunks.reserve(front + (numOldChunks - back) + (backStart - frontEnd) / chunkSize + 1);
+    snapshot->chunks.insert(snapshot->chunks.end(), oldChunks.begin(), oldChunks.begin() + front);
+    appendChunks(*snapshot, frontEnd, backStart);
+    snapshot->chunks.insert(snapshot->chunks.end(), oldChunks.begin() + back, oldChunks.end());
+    
+    //repeated edits in the same place leave small chunks behind, repack once they pile up
+    if ((int) snapshot->chunks.size() > 2 * (numNodes / chunkSize + 1)) {
+        snapshot->chunks.clear();
+        appendChunks(*snapshot, 0, numNodes);
+    }
+    
+    return snapshot;
+}
+
+void ShapeHistory::appendChunks(ShapeSnapshot& snapshot, int start, int end) {
+    for (int i = start; i < end; i += chunkSize) {
+        const int last = juce::jmin(end, i + chunkSize);
+        snapshot.chunks.push_back(std::make_shared<const ShapeSnapshot::Chunk>(current.begin() + i, current.begin() + last));
+    }
+}
+
+void ShapeHistory::restore(const ShapeSnapshot& snapshot, ShapeGraph& graph) {
+    nodePositions.clear();
+    edgeDeviations.clear();
+    edgeTypes.clear();
+    for (const auto& chunk : snapshot.chunks) {
+        for (const auto& state : *chunk) {
+            nodePositions.push_back({ state.x, state.y });
+            edgeDeviations.push_back({ state.xDeviation, state.yDeviation });
+            edgeTypes.push_back(state.type);
+        }
+    }
+    //the last node has no outgoing edge
+    if (!edgeDeviations.empty()) {
+        edgeDeviations.pop_back();
+        edgeTypes.pop_back();
+    }
+    
+    graph.restoreLayout(nodePositions, edgeDeviations, edgeTypes);
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ShapeHistory.h
+    Created: 18 Oct 2026 3:05:52pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <deque>
+#include "ShapeGraph.h"
+
+
+///position of a node and the deviation and type of the edge that starts at it
+struct ShapeNodeState {
+    float x, y;
+    float xDeviation, yDeviation;
+    SegmentType type;
+    
+    bool operator==(const ShapeNodeState& other) const {
+        return x == other.x && y == other.y && xDeviation == other.xDeviation && yDeviation == other.yDeviation
+            && type == other.type;
+    }
+    bool operator!=(const ShapeNodeState& other) const { return !(*this == other); }
+};
+
+///immutable state of a shape, stored as a list of shared chunks
+///a new snapshot reuses every chunk of the previous one that didn't change
+struct ShapeSnapshot {
+    using Chunk = std::vector<ShapeNodeState>;
+    
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+    int numNodes = 0;
+};
+
+
+///undo/redo stack of shape snapshots
+class ShapeHistory {
+    
+private:
+    
+    static constexpr int maxSteps = 4096;
+    static constexpr int chunkSize = 16;
+    
+    //back() is the current state
+    std::deque<std::shared_ptr<const ShapeSnapshot>> undoStack;
+    std::vector<std::shared_ptr<const ShapeSnapshot>> redoStack;
+    
+    //reused buffers, so capturing doesn't allocate beyond the changed chunks
+    std::vector<ShapeNodeState> current;
+    std::vector<juce::Point<float>> nodePositions;
+    std::vector<juce::Point<float>> edgeDeviations;
+    std::vector<SegmentType> edgeTypes;
+    
+    std::shared_ptr<const ShapeSnapshot> capture(const ShapeGraph& graph, const std::shared_ptr<const ShapeSnapshot>& previous);
+    void restore(const ShapeSnapshot& snapshot, ShapeGraph& graph);
+    void appendChunks(ShapeSnapshot& snapshot, int start, int end);
+    
+public:
+    
+    void reset(const ShapeGraph& graph);
+    bool push(const ShapeGraph& graph);
+    bool undo(ShapeGraph& graph);
+    bool redo(ShapeGraph& graph);
+    bool canUndo() const;
+    bool canRedo() const;
+};
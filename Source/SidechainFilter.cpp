@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    SidechainFilter.cpp
+    Created: 20 Oct 2026 11:18:52am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "SidechainFilter.h"
+
+void SidechainFilter::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    updateCoefficients();
+    reset();
+}
+
+void SidechainFilter::reset() {
+    z1 = FloatLanes::broadcast(0.0f);
+    z2 = FloatLanes::broadcast(0.0f);
+    pipeline[0] = 0.0f;
+    pipeline[1] = 0.0f;
+}
+
+bool SidechainFilter::isActive() const {
+    return type != Type::Off;
+}
+
+void SidechainFilter::setParameters(Type newType, float newFrequency) {
+    ///only recalculates when something changed, so it can be called every block
+    if (newType == type && newFrequency == frequency)
+        return;
+    
+    if (newType != type)
+        reset();
+    type = newType;
+    frequency = newFrequency;
+    updateCoefficients();
+}
+
+void SidechainFilter::updateCoefficients() {
+    ///RBJ cookbook biquads, the two stages of high/lowpass use the Q values of a 4th order butterworth
+    const float stageQ[2] = { type == Type::Bandpass ? 0.7071f : 0.5412f, type == Type::Bandpass ? 0.7071f : 1.3066f };
+    const float limited = juce::jlimit(10.0f, (float) (sampleRate * 0.49), frequency);
+    const float w0 = juce::MathConstants<float>::twoPi * limited / (float) sampleRate;
+    const float cosW0 = std::cos(w0);
+    const float sinW0 = std::sin(w0);
+    
+    for (int stage = 0; stage < 2; ++stage) {
+        const float alpha = sinW0 / (2.0f * stageQ[stage]);
+        const float a0 = 1.0f + alpha;
+        float nb0, nb1, nb2;
+        switch (type) {
+            case Type::Highpass:
+                nb0 = (1.0f + cosW0) * 0.5f;
+                nb1 = -(1.0f + cosW0);
+                nb2 = nb0;
+                break;
+            case Type::Lowpass:
+                nb0 = (1.0f - cosW0) * 0.5f;
+                nb1 = 1.0f - cosW0;
+                nb2 = nb0;
+                break;
+            case Type::Bandpass:
+                nb0 = alpha;
+                nb1 = 0.0f;
+                nb2 = -alpha;
+                break;
+            case Type::Off:
+            default:
+                nb0 = a0;
+                nb1 = 0.0f;
+                nb2 = 0.0f;
+                break;
+        }
+        
+        //both channels of a stage share the coefficients
+        for (int lane = stage * 2; lane < stage * 2 + 2; ++lane) {
+            b0.v[lane] = nb0 / a0;
+            b1.v[lane] = nb1 / a0;
+            b2.v[lane] = nb2 / a0;
+            a1.v[lane] = (type == Type::Off ? 0.0f : -2.0f * cosW0) / a0;
+            a2.v[lane] = (type == Type::Off ? 0.0f : 1.0f - alpha) / a0;
+        }
+    }
+}
+
+void SidechainFilter::process(const float* left, const float* right, float* outLeft, float* outRight, int numSamples) {
+    ///outputs may point at the inputs, right may be the same as left for a mono sidechain
+    //first stage output of the previous sample, the input of the second stage
+    float stageLeft = pipeline[0];
+    float stageRight = pipeline[1];
+    
+    for (int i = 0; i < numSamples; ++i) {
+        const FloatLanes x = { { left[i], right[i], stageLeft, stageRight } };
+        const FloatLanes y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        
+        stageLeft = y.v[0];
+        stageRight = y.v[1];
+        outLeft[i] = y.v[2];
+        outRight[i] = y.v[3];
+    }
+    
+    pipeline[0] = stageLeft;
+    pipeline[1] = stageRight;
+}
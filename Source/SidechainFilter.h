@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    SidechainFilter.h
+    Created: 20 Oct 2026 11:18:52am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include "SimdLanes.h"
+
+
+///prefilter for the sidechain detection, two biquads in series (4th order) for both channels
+///the four biquads run as one on FloatLanes: lanes 0/1 are the first stage, lanes 2/3 the second stage
+///working on the first stage's output of the previous sample, so the cascade is pipelined with one sample delay
+class SidechainFilter {
+    
+public:
+    
+    enum class Type { Off, Highpass, Lowpass, Bandpass };
+    
+    void prepare(double sampleRate);
+    void reset();
+    void setParameters(Type newType, float newFrequency);
+    bool isActive() const;
+    
+    void process(const float* left, const float* right, float* outLeft, float* outRight, int numSamples);
+    
+private:
+    
+    double sampleRate = 44100.0;
+    Type type = Type::Off;
+    float frequency = 1000.0f;
+    
+    //transposed direct form II, a0 normalized away
+    FloatLanes b0, b1, b2, a1, a2;
+    FloatLanes z1 = FloatLanes::broadcast(0.0f);
+    FloatLanes z2 = FloatLanes::broadcast(0.0f);
+    float pipeline[2] = { 0.0f, 0.0f };     //first stage output waiting for the second stage
+    
+    void updateCoefficients();
+};
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SimdLanes.h
+    Created: 19 Oct 2026 2:26:37pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+
+
+///four floats processed together, e.g. two channels of two filters
+///written as fixed size loops over an aligned array, which compile to single SSE/NEON instructions
+///unlike juce::dsp::SIMDRegister the width doesn't change with AVX, so the lane layout stays the same everywhere
+struct alignas(16) FloatLanes {
+    float v[4];
+    
+    static FloatLanes broadcast(float value) {
+        return { { value, value, value, value } };
+    }
+    
+    static FloatLanes fromPairs(float a, float b) {
+        return { { a, a, b, b } };
+    }
+    
+    ///lanes 0 and 1 from low, lanes 2 and 3 from high
+    static FloatLanes blend(const FloatLanes& low, const FloatLanes& high) {
+        return { { low.v[0], low.v[1], high.v[2], high.v[3] } };
+    }
+    
+    FloatLanes operator+(const FloatLanes& other) const {
+        FloatLanes result;
+        for (int i = 0; i < 4; ++i) result.v[i] = v[i] + other.v[i];
+        return result;
+    }
+    
+    FloatLanes operator-(const FloatLanes& other) const {
+        FloatLanes result;
+        for (int i = 0; i < 4; ++i) result.v[i] = v[i] - other.v[i];
+        return result;
+    }
+    
+    FloatLanes operator*(const FloatLanes& other) const {
+        FloatLanes result;
+        for (int i = 0; i < 4; ++i) result.v[i] = v[i] * other.v[i];
+        return result;
+    }
+};
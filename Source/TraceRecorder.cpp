@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+    Created: 19 Oct 2026 1:27:52am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+#include "LoadMeter.h"
+
+std::atomic<bool> TraceRecorder::recording { false };
+
+TraceRecorder::TraceRecorder() : juce::Thread("Trace Recorder") {
+    for (auto& ring : rings)
+        ring.events.resize(ringSize);
+}
+
+TraceRecorder::~TraceRecorder() {
+    stop();
+}
+
+TraceRecorder& TraceRecorder::getInstance() {
+    static TraceRecorder instance;
+    return instance;
+}
+
+juce::uint64 TraceRecorder::readCounter() {
+    return LoadMeter::readCounter();
+}
+
+juce::Result TraceRecorder::start(const juce::File& file) {
+    const juce::ScopedLock sl(startStopLock);
+    if (isRecording())
+        return juce::Result::fail("Already recording");
+
+    file.deleteFile();
+    output = file.createOutputStream();
+    if (output == nullptr)
+        return juce::Result::fail("Couldn't write " + file.getFullPathName());
+
+    //whatever is still in the rings is from an earlier recording
+    for (auto& ring : rings)
+        ring.readIndex.store(ring.writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    writtenThreadNames.fill(nullptr);
+
+    origin = readCounter();
+    microsecondsPerTick = 1.0e6 / LoadMeter::getCounterFrequency();
+    firstEvent = true;
+    *output << "{\"traceEvents\":[\n";
+
+    recording = true;
+    startThread(juce::Thread::Priority::low);
+    return juce::Result::ok();
+}
+
+void TraceRecorder::stop() {
+    const juce::ScopedLock sl(startStopLock);
+    if (!isRecording())
+        return;
+
+    recording = false;
+    stopThread(1000);
+    flush();
+    *output << "\n]}\n";
+    output.reset();
+}
+
+void TraceRecorder::startFromEnvironment() {
+    const auto path = juce::SystemStats::getEnvironmentVariable("LFOTOOL_TRACE_FILE", {});
+    if (path.isNotEmpty() && !isRecording())
+        start(juce::File::getCurrentWorkingDirectory().getChildFile(path));
+}
+
+TraceRecorder::Ring* TraceRecorder::getRingForThisThread() {
+    thread_local Ring* ring = nullptr;
+    thread_local bool untraced = false;
+    if (ring == nullptr && !untraced) {
+        const int index = numRingsClaimed.fetch_add(1);
+        if (index < maxThreads)
+            ring = &rings[(size_t) index];
+        else
+            untraced = true;
+    }
+    return ring;
+}
+
+void TraceRecorder::record(const char* name, juce::uint64 start, juce::uint64 duration) {
+    auto* ring = getInstance().getRingForThisThread();
+    if (ring == nullptr)
+        return;
+
+    const auto write = ring->writeIndex.load(std::memory_order_relaxed);
+    if (write - ring->readIndex.load(std::memory_order_acquire) >= (juce::uint32) ringSize) {
+        ring->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->events[write & (ringSize - 1)] = { name, start, duration };
+    ring->writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void TraceRecorder::setThreadName(const char* name) {
+    if (!isRecording())
+        return;
+    if (auto* ring = getInstance().getRingForThisThread())
+        ring->threadName.store(name);
+}
+
+void TraceRecorder::run() {
+    while (!threadShouldExit()) {
+        wait(50);
+        flush();
+    }
+}
+
+void TraceRecorder::flush() {
+    ///complete events ("X") with start and duration in microseconds, the ring index is the thread id
+    const int numRings = juce::jmin(numRingsClaimed.load(), maxThreads);
+    juce::String text;
+
+    auto addLine = [&](const juce::String& line) {
+        text << (firstEvent ? "" : ",\n") << line;
+        firstEvent = false;
+    };
+
+    for (int index = 0; index < numRings; ++index) {
+        auto& ring = rings[(size_t) index];
+
+        const char* threadName = ring.threadName.load();
+        if (threadName != nullptr && threadName != writtenThreadNames[(size_t) index]) {
+            writtenThreadNames[(size_t) index] = threadName;
+            addLine("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + juce::String(index)
+                    + ",\"args\":{\"name\":\"" + threadName + "\"}}");
+        }
+
+        const auto write = ring.writeIndex.load(std::memory_order_acquire);
+        auto read = ring.readIndex.load(std::memory_order_relaxed);
+        for (; read != write; ++read) {
+            const auto& event = ring.events[read & (ringSize - 1)];
+            const double start = (double) (juce::int64) (event.start - origin) * microsecondsPerTick;
+            addLine("{\"name\":\"" + juce::String(event.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + juce::String(index)
+                    + ",\"ts\":" + juce::String(start, 3) + ",\"dur\":" + juce::String((double) event.duration * microsecondsPerTick, 3) + "}");
+        }
+        ring.readIndex.store(read, std::memory_order_release);
+
+        if (const auto dropped = ring.numDropped.exchange(0))
+            addLine("{\"name\":\"dropped " + juce::String((int) dropped) + " events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":"
+                    + juce::String(index) + ",\"ts\":" + juce::String((double) (juce::int64) (readCounter() - origin) * microsecondsPerTick, 3) + "}");
+    }
+
+    if (text.isNotEmpty()) {
+        *output << text;
+        output->flush();
+    }
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 19 Oct 2026 1:27:52am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+
+//off by default, with 0 the scope macros expand to nothing
+#ifndef LFOTOOL_TRACE
+ #define LFOTOOL_TRACE 0
+#endif
+
+
+///records timed scopes from any thread and writes them as a Chrome/Perfetto trace (chrome://tracing, ui.perfetto.dev)
+///every thread writes into its own preallocated single producer ring, a background thread drains the rings into the file
+///recording is two counter reads and one fixed-size store, it never blocks or allocates, a full ring drops events
+///one recorder per process, so several plugin instances end up in the same trace
+class TraceRecorder : private juce::Thread {
+
+public:
+
+    struct Event {
+        const char* name;       //has to be a string literal, only the pointer is stored
+        juce::uint64 start;
+        juce::uint64 duration;
+    };
+
+    ///times the enclosing scope, does nothing while not recording
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(name), start(isRecording() ? readCounter() : 0) {}
+        ~Scope() { if (start != 0) record(name, start, readCounter() - start); }
+    private:
+        const char* name;
+        const juce::uint64 start;
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    static TraceRecorder& getInstance();
+
+    //message thread
+    juce::Result start(const juce::File& file);
+    void stop();
+    ///starts recording into the file named by the LFOTOOL_TRACE_FILE environment variable, if it is set
+    void startFromEnvironment();
+
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+    static void record(const char* name, juce::uint64 start, juce::uint64 duration);
+    ///names the calling thread in the trace, name has to be a string literal
+    static void setThreadName(const char* name);
+    static juce::uint64 readCounter();
+
+private:
+
+    static constexpr int maxThreads = 32;
+    static constexpr int ringSize = 1 << 13;    //events per thread between two flushes
+
+    struct Ring {
+        std::vector<Event> events;
+        std::atomic<juce::uint32> writeIndex { 0 };     //owned by the recording thread
+        std::atomic<juce::uint32> readIndex { 0 };      //owned by the flush thread
+        std::atomic<juce::uint32> numDropped { 0 };
+        std::atomic<const char*> threadName { nullptr };
+    };
+
+    static std::atomic<bool> recording;
+
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    void run() override;
+    void flush();
+    Ring* getRingForThisThread();
+
+    std::array<Ring, maxThreads> rings;
+    //threads claim a ring on their first event and keep it, threads beyond maxThreads aren't traced
+    std::atomic<int> numRingsClaimed { 0 };
+
+    //used by the flush thread, and by start and stop while it isn't running
+    std::unique_ptr<juce::FileOutputStream> output;
+    std::array<const char*, maxThreads> writtenThreadNames {};
+    juce::uint64 origin = 0;
+    double microsecondsPerTick = 0.0;
+    bool firstEvent = true;
+    juce::CriticalSection startStopLock;
+};
+
+#if LFOTOOL_TRACE
+ #define LFOTOOL_TRACE_JOIN_(a, b) a##b
+ #define LFOTOOL_TRACE_JOIN(a, b) LFOTOOL_TRACE_JOIN_(a, b)
+ #define LFOTOOL_TRACE_SCOPE(name) const TraceRecorder::Scope LFOTOOL_TRACE_JOIN(traceScope, __LINE__) (name);
+ #define LFOTOOL_TRACE_THREAD(name) TraceRecorder::setThreadName(name);
+#else
+ #define LFOTOOL_TRACE_SCOPE(name)
+ #define LFOTOOL_TRACE_THREAD(name)
+#endif
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    TransientDetector.cpp
+    Created: 20 Oct 2026 3:40:09pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "TransientDetector.h"
+#include "TraceRecorder.h"
+
+TransientDetector::TransientDetector() : fft(fftOrder) {
+    ///everything the audio thread touches is allocated here
+    window.resize(fftSize);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+    ring.resize(fftSize, 0.0f);
+    frame.resize(2 * fftSize, 0.0f);
+    previousMagnitudes.resize(numBins, 0.0f);
+    fluxHistory.resize(historySize, 0.0f);
+}
+
+void TransientDetector::prepare(double sampleRate) {
+    //no retrigger within 50ms of an onset
+    holdoffSamples = juce::roundToInt(0.05 * sampleRate);
+    reset();
+}
+
+void TransientDetector::reset() {
+    std::fill(ring.begin(), ring.end(), 0.0f);
+    std::fill(previousMagnitudes.begin(), previousMagnitudes.end(), 0.0f);
+    std::fill(fluxHistory.begin(), fluxHistory.end(), 0.0f);
+    ringPosition = 0;
+    samplesUntilFrame = hopSize;
+    historyPosition = 0;
+    previousFlux = 0.0f;
+    samplesSinceOnset = holdoffSamples;
+}
+
+int TransientDetector::process(const float* left, const float* right, int numSamples, float sensitivity) {
+    LFOTOOL_TRACE_SCOPE("TransientDetector::process")
+    int onset = -1;
+    for (int i = 0; i < numSamples; ++i) {
+        ring[ringPosition] = 0.5f * (left[i] + right[i]);
+        ringPosition = (ringPosition + 1) & (fftSize - 1);
+        ++samplesSinceOnset;
+        
+        if (--samplesUntilFrame == 0) {
+            samplesUntilFrame = hopSize;
+            if (analyseFrame(sensitivity) && onset < 0)
+                onset = i;
+        }
+    }
+    return onset;
+}
+
+bool TransientDetector::analyseFrame(float sensitivity) {
+    ///flux is the summed rise of the log magnitudes since the last frame,
+    ///an onset is a rising flux above the recent mean times a factor set by the sensitivity
+    for (int i = 0; i < fftSize; ++i)
+        frame[i] = ring[(ringPosition + i) & (fftSize - 1)] * window[i];
+    std::fill(frame.begin() + fftSize, frame.end(), 0.0f);
+    fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+    
+    float flux = 0.0f;
+    for (int bin = 0; bin < numBins; ++bin) {
+        const float magnitude = std::log1p(100.0f * frame[bin]);
+        flux += juce::jmax(0.0f, magnitude - previousMagnitudes[bin]);
+        previousMagnitudes[bin] = magnitude;
+    }
+    
+    float mean = 0.0f;
+    for (float value : fluxHistory)
+        mean += value;
+    mean /= historySize;
+    fluxHistory[historyPosition] = flux;
+    historyPosition = (historyPosition + 1) % historySize;
+    
+    //sensitivity 0 needs 4x the mean, 1 only 1.25x, the offset ignores noise in near silence
+    const float factor = 4.0f - 2.75f * juce::jlimit(0.0f, 1.0f, sensitivity);
+    const bool rising = flux > previousFlux;
+    previousFlux = flux;
+    
+    if (rising && flux > factor * mean + 1.0f && samplesSinceOnset >= holdoffSamples) {
+        samplesSinceOnset = 0;
+        return true;
+    }
+    return false;
+}
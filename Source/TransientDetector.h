@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+    Created: 20 Oct 2026 3:40:09pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+
+///onset detection for the sidechain trigger, spectral flux against an adaptive threshold
+///samples go into a preallocated ring, every hopSize samples one windowed FFT frame is analysed,
+///so the work per block only depends on the block length and nothing is allocated after prepare()
+class TransientDetector {
+    
+public:
+    
+    static constexpr int fftOrder = 9;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = 128;
+    
+    TransientDetector();
+    
+    void prepare(double sampleRate);
+    void reset();
+    
+    ///returns the sample offset of the first onset in the block, -1 if there was none
+    int process(const float* left, const float* right, int numSamples, float sensitivity);
+    ///samples left until the next frame is analysed, blocks cut there hold at most one onset, always on their last sample
+    int getSamplesUntilFrame() const { return samplesUntilFrame; }
+    
+private:
+    
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int historySize = 16;      //flux frames the threshold is averaged over, ~46ms at 44.1kHz
+    
+    juce::dsp::FFT fft;
+    std::vector<float> window;
+    std::vector<float> ring;
+    std::vector<float> frame;
+    std::vector<float> previousMagnitudes;
+    std::vector<float> fluxHistory;
+    
+    int ringPosition = 0;
+    int samplesUntilFrame = hopSize;
+    int historyPosition = 0;
+    float previousFlux = 0.0f;
+    int holdoffSamples = 0;
+    int samplesSinceOnset = 0;
+    
+    bool analyseFrame(float sensitivity);
+};
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    WaveformHistory.cpp
+    Created: 18 Oct 2026 10:12:31am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "WaveformHistory.h"
+
+WaveformHistory::WaveformHistory() = default;
+
+void WaveformHistory::setEnabled(bool shouldBeEnabled) {
+    ///allocates on the first call, push() never sees the buffers before they exist because it only runs once enabled
+    ///re-enabling starts over, whatever is left in the fifo is from before the gap
+    if (shouldBeEnabled == enabled.load())
+        return;
+
+    if (shouldBeEnabled) {
+        if (fifoBuffer.empty()) {
+            fifoBuffer.resize(fifoSize, 0.0f);
+            for (int level = 0; level < numLevels; ++level) {
+                levels[level].minValues.resize(numBaseBins >> level, 0.0f);
+                levels[level].maxValues.resize(numBaseBins >> level, 0.0f);
+            }
+        }
+        fifo.read(fifo.getNumReady());
+        clear();
+    }
+    enabled.store(shouldBeEnabled, std::memory_order_release);
+}
+
+void WaveformHistory::push(const float* samples, int numSamples) {
+    ///copy the block into the fifo, if the GUI doesn't keep up the newest samples are dropped
+    if (!enabled.load(std::memory_order_acquire))
+        return;
+
+    const auto scope = fifo.write(numSamples);
+
+    if (scope.blockSize1 > 0)
+        std::copy(samples, samples + scope.blockSize1, fifoBuffer.data() + scope.startIndex1);
+    if (scope.blockSize2 > 0)
+        std::copy(samples + scope.blockSize1, samples + scope.blockSize1 + scope.blockSize2, fifoBuffer.data() + scope.startIndex2);
+}
+
+void WaveformHistory::pull() {
+    ///drain everything the audio thread wrote since the last call into the pyramid
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    if (scope.blockSize1 > 0)
+        addSamples(fifoBuffer.data() + scope.startIndex1, scope.blockSize1);
+    if (scope.blockSize2 > 0)
+        addSamples(fifoBuffer.data() + scope.startIndex2, scope.blockSize2);
+}
+
+void WaveformHistory::clear() {
+    completedBins = 0;
+    partialCount = 0;
+}
+
+void WaveformHistory::addSamples(const float* samples, int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+        const float value = samples[i];
+        if (partialCount == 0) {
+            partialMin = value;
+            partialMax = value;
+        } else {
+            partialMin = juce::jmin(partialMin, value);
+            partialMax = juce::jmax(partialMax, value);
+        }
+
+        if (++partialCount == baseBinSize)
+            completeBin();
+    }
+}
+
+void WaveformHistory::completeBin() {
+    ///write the finished bin to level 0 and merge upwards as long as a pair is complete
+    juce::int64 bin = completedBins;
+    int slot = (int) (bin % (numBaseBins));
+    levels[0].minValues[slot] = partialMin;
+    levels[0].maxValues[slot] = partialMax;
+
+    for (int level = 1; level < numLevels; ++level) {
+        if ((bin & 1) == 0)
+            break;
+
+        const auto& lower = levels[level - 1];
+        const int lowerSize = numBaseBins >> (level - 1);
+        const int right = (int) (bin % lowerSize);
+        const int left = (int) ((bin - 1) % lowerSize);
+
+        bin >>= 1;
+        const int slotUp = (int) (bin % (numBaseBins >> level));
+        levels[level].minValues[slotUp] = juce::jmin(lower.minValues[left], lower.minValues[right]);
+        levels[level].maxValues[slotUp] = juce::jmax(lower.maxValues[left], lower.maxValues[right]);
+    }
+
+    ++completedBins;
+    partialCount = 0;
+}
+
+juce::int64 WaveformHistory::getNumSamples() const {
+    return completedBins * baseBinSize;
+}
+
+bool WaveformHistory::getMinMax(juce::int64 startSample, juce::int64 endSample, float& minValue, float& maxValue) const {
+    ///min/max over the absolute sample range [startSample, endSample)
+    ///picks the coarsest level that still resolves the range into a few bins, so the cost doesn't depend on its length
+    juce::int64 firstBin = juce::jmax(startSample / baseBinSize, completedBins - numBaseBins, (juce::int64) 0);
+    juce::int64 lastBin = juce::jmin((endSample - 1) / baseBinSize, completedBins - 1);
+    if (lastBin < firstBin)
+        return false;
+
+    int level = 0;
+    while (level < numLevels - 1 && ((lastBin - firstBin) >> (level + 1)) >= 2)
+        ++level;
+
+    //only use bins on this level that are complete and still inside the ring
+    const int levelSize = numBaseBins >> level;
+    const juce::int64 newestComplete = (completedBins >> level) - 1;
+    juce::int64 first = juce::jmax(firstBin >> level, newestComplete - levelSize + 1);
+    juce::int64 last = juce::jmin(lastBin >> level, newestComplete);
+    if (last < first)
+        return false;
+
+    const auto& data = levels[level];
+    minValue = data.minValues[(int) (first % levelSize)];
+    maxValue = data.maxValues[(int) (first % levelSize)];
+    for (juce::int64 bin = first + 1; bin <= last; ++bin) {
+        const int slot = (int) (bin % levelSize);
+        minValue = juce::jmin(minValue, data.minValues[slot]);
+        maxValue = juce::jmax(maxValue, data.maxValues[slot]);
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    WaveformHistory.h
+    Created: 18 Oct 2026 10:12:31am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+
+///keeps a min/max history of an audio signal for drawing behind the shape
+///the audio thread only copies samples into a lock-free fifo, the message thread drains it
+///into a pyramid of min/max bins, so a query over any range only touches a handful of bins
+///the buffers are over 1MB, so they are only allocated and fed once an editor enables the history
+class WaveformHistory {
+
+private:
+
+    static constexpr int fifoSize = 1 << 16;        //enough for several GUI frames at 192kHz
+    static constexpr int baseBinSize = 16;          //samples per bin on the finest level
+    static constexpr int numLevels = 14;
+    static constexpr int numBaseBins = 1 << 16;     //~1M samples of history
+
+    struct Level {
+        std::vector<float> minValues;
+        std::vector<float> maxValues;
+    };
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::vector<float> fifoBuffer;
+
+    std::array<Level, numLevels> levels;
+    std::atomic<bool> enabled { false };
+    juce::int64 completedBins = 0;
+    int partialCount = 0;
+    float partialMin = 0.0f;
+    float partialMax = 0.0f;
+
+    void addSamples(const float* samples, int numSamples);
+    void completeBin();
+
+public:
+
+    WaveformHistory();
+
+    //audio thread
+    void push(const float* samples, int numSamples);
+
+    //message thread
+    void setEnabled(bool shouldBeEnabled);
+    void pull();
+    void clear();
+    juce::int64 getNumSamples() const;
+    bool getMinMax(juce::int64 startSample, juce::int64 endSample, float& minValue, float& maxValue) const;
+};
@@ -0,0 +1,541 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+    Created: 18 Oct 2026 10:31:47pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Common/RandomShapes.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace {
+
+constexpr bool hasCycleCounter = JUCE_INTEL != 0;
+
+juce::uint64 readCycleCounter() {
+   #if JUCE_INTEL
+    return __rdtsc();
+   #else
+    return 0;
+   #endif
+}
+
+///transport that runs from the start at 120 bpm, advanced by the benchmark loop
+class BenchmarkPlayHead : public juce::AudioPlayHead {
+public:
+    juce::Optional<PositionInfo> getPosition() const override {
+        PositionInfo info;
+        info.setBpm(120.0);
+        info.setIsPlaying(true);
+        info.setTimeInSamples(timeInSamples);
+        info.setPpqPosition(timeInSamples / sampleRate * 2.0);
+        return info;
+    }
+
+    double sampleRate = 48000.0;
+    juce::int64 timeInSamples = 0;
+};
+
+void makeShape(ShapeGraph& graph, int nodes) {
+    ///seeded with the node count, so every run and every commit measures the same shape
+    juce::Random random(nodes);
+    RandomShapes::layout(graph);
+    RandomShapes::fill(graph, nodes, random);
+}
+
+void setParameter(RectanglesAudioProcessor& processor, const juce::String& id, float value) {
+    if (auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(processor.parameters.getParameter(id)))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+bool setUpProcessor(RectanglesAudioProcessor& processor, const juce::String& mode, int channels, int nodes) {
+    //channels is the main input, only layouts the plugin accepts are measured
+    auto layout = processor.getBusesLayout();
+    layout.inputBuses.getReference(0) = channels == 1 ? juce::AudioChannelSet::mono()
+                                      : channels == 2 ? juce::AudioChannelSet::stereo()
+                                                      : juce::AudioChannelSet::discreteChannels(channels);
+    if (!processor.setBusesLayout(layout))
+        return false;
+
+    //multiband splits into all four bands with the same shape on each, so compared to free it is the cost of the split
+    const int numBands = mode == "multiband" ? RectanglesAudioProcessor::maxBands : 1;
+    ShapeGraph graph;
+    makeShape(graph, nodes);
+    for (int band = 0; band < numBands; ++band)
+        processor.loadShapeGraphXml(*graph.createXML(), band);
+
+    setParameter(processor, "bands", (float) (numBands - 1));
+    setParameter(processor, "destination", mode == "filter" ? 1.0f : 0.0f);
+    setParameter(processor, "sync", mode == "sync" ? 1.0f : 0.0f);
+    setParameter(processor, "sc", mode == "sidechain" ? 1.0f : 0.0f);
+    setParameter(processor, "pan offset", mode == "pan" ? 0.25f : 0.0f);
+    setParameter(processor, "lfo rate", 2.0f);
+    return true;
+}
+
+void makeInputs(double sampleRate, juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& sidechain) {
+    ///one second of noise on the inputs, the sidechain gets 10ms bursts five times a second so it keeps retriggering
+    const int sourceLength = (int) sampleRate;
+    source.setSize(2, sourceLength);
+    sidechain.setSize(2, sourceLength);
+    juce::Random random(1);
+    sidechain.clear();
+    for (int channel = 0; channel < 2; ++channel) {
+        for (int i = 0; i < sourceLength; ++i) {
+            source.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+            if (i % (sourceLength / 5) < sourceLength / 100)
+                sidechain.setSample(channel, i, 0.8f * (random.nextFloat() * 2.0f - 1.0f));
+        }
+    }
+}
+
+///one plugin instance of the scaling run with everything a host keeps per instance
+struct HostedInstance {
+    RectanglesAudioProcessor processor;
+    BenchmarkPlayHead playHead;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    int numAuxChannels = 0;
+    int position = 0;
+
+    void prepare(double sampleRate, int blockSize) {
+        playHead.sampleRate = sampleRate;
+        processor.setPlayHead(&playHead);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const auto* aux = processor.getBus(true, 1);
+        numAuxChannels = aux != nullptr && aux->isEnabled() ? aux->getNumberOfChannels() : 0;
+        buffer.setSize(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+    }
+
+    void process(const juce::AudioBuffer<float>& source, const juce::AudioBuffer<float>& sidechain) {
+        const int blockSize = buffer.getNumSamples();
+        if (position + blockSize > source.getNumSamples())
+            position = 0;
+        for (int channel = 0; channel < processor.getMainBusNumInputChannels(); ++channel)
+            buffer.copyFrom(channel, 0, source, channel % 2, position, blockSize);
+        for (int channel = 0; channel < numAuxChannels; ++channel)
+            buffer.copyFrom(processor.getChannelIndexInProcessBlockBuffer(true, 1, channel), 0, sidechain, channel % 2, position, blockSize);
+
+        playHead.timeInSamples += blockSize;
+        midi.clear();
+        processor.processBlock(buffer, midi);
+        position += blockSize;
+    }
+};
+
+///worker threads that process every instance once per host cycle, the way a host spreads its plugins
+///the instances are handed out through an atomic counter and the calling thread takes part as well,
+///idle workers spin on the cycle counter, so nothing but the processing itself is measured
+class HostSimulation {
+public:
+    HostSimulation(std::vector<std::unique_ptr<HostedInstance>>& instances, const juce::AudioBuffer<float>& source,
+                   const juce::AudioBuffer<float>& sidechain, int numThreads)
+        : instances(instances), source(source), sidechain(sidechain) {
+        for (int i = 1; i < numThreads; ++i)
+            workers.emplace_back([this] { runWorker(); });
+    }
+
+    ~HostSimulation() {
+        quit.store(true);
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    void runCycle() {
+        //remaining is set first, a worker still leaving the last cycle may already pick up an instance of this one
+        remaining.store((int) instances.size(), std::memory_order_relaxed);
+        nextInstance.store(0, std::memory_order_release);
+        cycle.fetch_add(1, std::memory_order_release);
+
+        processInstances();
+        while (remaining.load(std::memory_order_acquire) > 0)
+            std::this_thread::yield();
+    }
+
+private:
+    std::vector<std::unique_ptr<HostedInstance>>& instances;
+    const juce::AudioBuffer<float>& source;
+    const juce::AudioBuffer<float>& sidechain;
+    std::vector<std::thread> workers;
+    std::atomic<int> cycle { 0 };
+    std::atomic<int> nextInstance { 0 };
+    std::atomic<int> remaining { 0 };
+    std::atomic<bool> quit { false };
+
+    void runWorker() {
+        juce::ScopedNoDenormals noDenormals;
+        int lastCycle = 0;
+        while (!quit.load(std::memory_order_relaxed)) {
+            const int current = cycle.load(std::memory_order_acquire);
+            if (current == lastCycle) {
+                std::this_thread::yield();
+                continue;
+            }
+            lastCycle = current;
+            processInstances();
+        }
+    }
+
+    void processInstances() {
+        const int numInstances = (int) instances.size();
+        for (int index = nextInstance.fetch_add(1); index < numInstances; index = nextInstance.fetch_add(1)) {
+            instances[(size_t) index]->process(source, sidechain);
+            remaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+};
+
+//keeps the optimizer from dropping the measured work
+volatile float sink = 0.0f;
+
+} //namespace
+
+Benchmarks::Benchmarks(const BenchmarkSettings& settings) : settings(settings) {}
+
+template <typename Function>
+void Benchmarks::measure(BenchmarkResult& result, juce::int64 samplesPerRun, Function&& run) const {
+    constexpr int numBatches = 9;
+
+    //warm up caches and branch predictors, then find how many runs fill one batch
+    run();
+    const auto batchTicks = juce::Time::secondsToHighResolutionTicks(settings.secondsPerCase / numBatches);
+    int runsPerBatch = 1;
+    for (;;) {
+        const auto start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < runsPerBatch; ++i)
+            run();
+        if (juce::Time::getHighResolutionTicks() - start >= batchTicks || runsPerBatch >= (1 << 20))
+            break;
+        runsPerBatch *= 2;
+    }
+
+    std::vector<double> ns, cycles;
+    for (int batch = 0; batch < numBatches; ++batch) {
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+        for (int i = 0; i < runsPerBatch; ++i)
+            run();
+        const auto endCycles = readCycleCounter();
+        const auto endTicks = juce::Time::getHighResolutionTicks();
+
+        const double units = (double) samplesPerRun * runsPerBatch;
+        ns.push_back(juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1.0e9 / units);
+        cycles.push_back((double) (endCycles - startCycles) / units);
+    }
+
+    std::sort(ns.begin(), ns.end());
+    std::sort(cycles.begin(), cycles.end());
+    result.nsMedian = ns[numBatches / 2];
+    result.nsMin = ns.front();
+    result.cyclesMedian = hasCycleCounter ? cycles[numBatches / 2] : -1.0;
+}
+
+void Benchmarks::benchmarkModulationValue(int nodes) {
+    ///one table read per sample, the way processSample reads it
+    ShapeGraph graph;
+    makeShape(graph, nodes);
+    Modulator modulator;
+    modulator.generateModulationValues(&graph);
+
+    constexpr int samplesPerRun = 4096;
+    const float increment = 1.0f / 997.0f;
+    float phase = 0.0f;
+
+    BenchmarkResult result { "getModulationValue", "", 0, 0, nodes };
+    measure(result, samplesPerRun, [&] {
+        bool hardEdge;
+        float sum = 0.0f;
+        for (int i = 0; i < samplesPerRun; ++i) {
+            sum += modulator.getModulationValue(phase, 0.0f, hardEdge);
+            phase += increment;
+            if (phase >= 1.0f)
+                phase -= 1.0f;
+        }
+        sink = sum;
+    });
+    results.push_back(result);
+}
+
+void Benchmarks::benchmarkGenerate(int nodes) {
+    ///the synchronous path, table evaluation, mip levels and the allocation of the new table
+    ShapeGraph graph;
+    makeShape(graph, nodes);
+    Modulator modulator;
+
+    BenchmarkResult result { "generateModulationValues", "", 0, 0, nodes, false };
+    measure(result, 1, [&] {
+        modulator.generateModulationValues(&graph);
+    });
+    results.push_back(result);
+}
+
+void Benchmarks::benchmarkTraceScope() {
+    ///one TraceRecorder::Scope per call, idle while nothing records and recording into a file
+    constexpr int scopesPerRun = 1024;
+    BenchmarkResult idle { "traceScope", "idle", 0, 0, 0, false };
+    measure(idle, scopesPerRun, [] {
+        for (int i = 0; i < scopesPerRun; ++i)
+            const TraceRecorder::Scope scope("benchmark");
+    });
+    results.push_back(idle);
+
+    //a thread's ring holds 8192 events and is drained every 50ms, a batch that overflows it would
+    //measure the drop path, so every batch is half a ring and the recorder gets two flushes in between
+    auto& recorder = TraceRecorder::getInstance();
+    const auto file = juce::File::createTempFile(".json");
+    if (recorder.start(file).failed())
+        return;
+
+    constexpr int numBatches = 9;
+    constexpr int scopesPerBatch = 4096;
+    std::vector<double> ns, cycles;
+    for (int batch = 0; batch < numBatches; ++batch) {
+        juce::Thread::sleep(110);
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+        for (int i = 0; i < scopesPerBatch; ++i)
+            const TraceRecorder::Scope scope("benchmark");
+        const auto endCycles = readCycleCounter();
+        const auto endTicks = juce::Time::getHighResolutionTicks();
+        ns.push_back(juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1.0e9 / scopesPerBatch);
+        cycles.push_back((double) (endCycles - startCycles) / scopesPerBatch);
+    }
+    recorder.stop();
+    file.deleteFile();
+
+    std::sort(ns.begin(), ns.end());
+    std::sort(cycles.begin(), cycles.end());
+    BenchmarkResult recording { "traceScope", "recording", 0, 0, 0, false };
+    recording.nsMedian = ns[numBatches / 2];
+    recording.nsMin = ns.front();
+    recording.cyclesMedian = hasCycleCounter ? cycles[numBatches / 2] : -1.0;
+    results.push_back(recording);
+}
+
+void Benchmarks::benchmarkProcessBlock(const juce::String& mode, int channels, int nodes) {
+    RectanglesAudioProcessor processor;
+    if (!setUpProcessor(processor, mode, channels, nodes))
+        return;
+
+    //trace is free with the recorder running, only builds with LFOTOOL_TRACE=1 have the scopes it times
+    //at small block sizes the rings overflow between flushes, those rows partly measure dropped events
+    const auto traceFile = juce::File::createTempFile(".json");
+    const bool tracing = mode == "trace" && TraceRecorder::getInstance().start(traceFile).wasOk();
+
+    BenchmarkPlayHead playHead;
+    playHead.sampleRate = settings.sampleRate;
+    processor.setPlayHead(&playHead);
+
+    juce::AudioBuffer<float> source, sidechain;
+    makeInputs(settings.sampleRate, source, sidechain);
+    const int sourceLength = source.getNumSamples();
+
+    for (int blockSize : settings.blockSizes) {
+        if (blockSize > sourceLength)
+            continue;
+
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, blockSize);
+        processor.prepareToPlay(settings.sampleRate, blockSize);
+
+        const int numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+        const auto* aux = processor.getBus(true, 1);
+        const int numAuxChannels = aux != nullptr && aux->isEnabled() ? aux->getNumberOfChannels() : 0;
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        //enough blocks per run that the loop overhead doesn't show at small block sizes
+        const int numBlocks = juce::jmax(1, 4096 / blockSize);
+        int position = 0;
+
+        BenchmarkResult result { "processBlock", mode, blockSize, channels, nodes };
+        measure(result, (juce::int64) numBlocks * blockSize, [&] {
+            ///the inputs are refilled every block like a host would, that copy is part of the measurement
+            juce::ScopedNoDenormals noDenormals;
+            for (int block = 0; block < numBlocks; ++block) {
+                if (position + blockSize > sourceLength)
+                    position = 0;
+                for (int channel = 0; channel < processor.getMainBusNumInputChannels(); ++channel)
+                    buffer.copyFrom(channel, 0, source, channel % 2, position, blockSize);
+                for (int channel = 0; channel < numAuxChannels; ++channel)
+                    buffer.copyFrom(processor.getChannelIndexInProcessBlockBuffer(true, 1, channel), 0, sidechain, channel % 2, position, blockSize);
+
+                playHead.timeInSamples += blockSize;
+                midi.clear();
+                processor.processBlock(buffer, midi);
+                position += blockSize;
+            }
+        });
+        results.push_back(result);
+        processor.releaseResources();
+    }
+
+    if (tracing) {
+        TraceRecorder::getInstance().stop();
+        traceFile.deleteFile();
+    }
+    processor.setPlayHead(nullptr);
+}
+
+void Benchmarks::benchmarkScaling(const juce::String& mode, int channels, int nodes, int blockSize) {
+    ///every thread count processes the same instances, one run is a few host cycles over all of them
+    if (blockSize > (int) settings.sampleRate)
+        return;
+
+    std::vector<std::unique_ptr<HostedInstance>> instances;
+    for (int i = 0; i < settings.instances; ++i) {
+        auto instance = std::make_unique<HostedInstance>();
+        if (!setUpProcessor(instance->processor, mode, channels, nodes))
+            return;
+        instance->prepare(settings.sampleRate, blockSize);
+        instances.push_back(std::move(instance));
+    }
+
+    juce::AudioBuffer<float> source, sidechain;
+    makeInputs(settings.sampleRate, source, sidechain);
+
+    auto threadCounts = settings.threadCounts;
+    if (threadCounts.isEmpty()) {
+        const int numCpus = juce::SystemStats::getNumCpus();
+        for (int threads = 1; threads < numCpus; threads *= 2)
+            threadCounts.add(threads);
+        threadCounts.add(numCpus);
+    }
+
+    //the editor writes through the setters while the audio runs, with a shared cache line this slows the audio threads down
+    std::atomic<bool> stopEditor { false };
+    std::thread editor;
+    if (settings.editorWrites) {
+        editor = std::thread([&] {
+            while (!stopEditor.load(std::memory_order_relaxed)) {
+                for (auto& instance : instances) {
+                    instance->processor.setDepth(1.0f);
+                    instance->processor.setPanOffset(mode == "pan" ? 0.25f : 0.0f);
+                    instance->processor.setLfoRate(2.0f);
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    const int cyclesPerRun = juce::jmax(1, 4096 / blockSize);
+    const size_t from = results.size();
+    for (int threads : threadCounts) {
+        HostSimulation host(instances, source, sidechain, threads);
+
+        BenchmarkResult result { "scaling", mode, blockSize, channels, nodes };
+        result.threads = threads;
+        result.instances = settings.instances;
+        measure(result, (juce::int64) cyclesPerRun * blockSize * settings.instances, [&] {
+            juce::ScopedNoDenormals noDenormals;
+            for (int cycle = 0; cycle < cyclesPerRun; ++cycle)
+                host.runCycle();
+        });
+        result.speedup = results.size() > from ? results[from].nsMedian / result.nsMedian : 1.0;
+        results.push_back(result);
+    }
+
+    stopEditor.store(true);
+    if (editor.joinable())
+        editor.join();
+    for (auto& instance : instances)
+        instance->processor.setPlayHead(nullptr);
+}
+
+void Benchmarks::run(std::function<void(const BenchmarkResult&)> onResult) {
+    ///each case reports as soon as it is done, a full run takes a while
+    auto report = [&](size_t from) {
+        for (size_t i = from; i < results.size(); ++i)
+            if (onResult)
+                onResult(results[i]);
+    };
+
+    for (int nodes : settings.nodeCounts) {
+        const size_t from = results.size();
+        benchmarkModulationValue(nodes);
+        benchmarkGenerate(nodes);
+        report(from);
+    }
+
+    {
+        const size_t from = results.size();
+        benchmarkTraceScope();
+        report(from);
+    }
+
+    for (auto& mode : settings.modes) {
+        for (int channels : settings.channelCounts) {
+            for (int nodes : settings.nodeCounts) {
+                const size_t from = results.size();
+                benchmarkProcessBlock(mode, channels, nodes);
+                report(from);
+            }
+        }
+    }
+}
+
+void Benchmarks::runScaling(std::function<void(const BenchmarkResult&)> onResult) {
+    for (auto& mode : settings.modes) {
+        for (int channels : settings.channelCounts) {
+            for (int nodes : settings.nodeCounts) {
+                for (int blockSize : settings.blockSizes) {
+                    const size_t from = results.size();
+                    benchmarkScaling(mode, channels, nodes, blockSize);
+                    for (size_t i = from; i < results.size(); ++i)
+                        if (onResult)
+                            onResult(results[i]);
+                }
+            }
+        }
+    }
+}
+
+juce::var Benchmarks::toJson(const juce::String& label) const {
+    juce::Array<juce::var> lines;
+    for (auto& result : results) {
+        auto* line = new juce::DynamicObject();
+        line->setProperty("benchmark", result.benchmark);
+        if (result.mode.isNotEmpty())
+            line->setProperty("mode", result.mode);
+        if (result.blockSize > 0)
+            line->setProperty("blockSize", result.blockSize);
+        if (result.channels > 0)
+            line->setProperty("channels", result.channels);
+        line->setProperty("nodes", result.nodes);
+        line->setProperty("unit", result.perSample ? "sample" : "call");
+        line->setProperty("ns", result.nsMedian);
+        line->setProperty("nsMin", result.nsMin);
+        if (result.cyclesMedian >= 0.0)
+            line->setProperty("cycles", result.cyclesMedian);
+        if (result.threads > 0) {
+            line->setProperty("threads", result.threads);
+            line->setProperty("instances", result.instances);
+            line->setProperty("speedup", result.speedup);
+        }
+        lines.add(juce::var(line));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("label", label);
+    root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+    root->setProperty("cores", juce::SystemStats::getNumCpus());
+    root->setProperty("physicalCores", juce::SystemStats::getNumPhysicalCpus());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("sampleRate", settings.sampleRate);
+    root->setProperty("results", lines);
+    return juce::var(root);
+}
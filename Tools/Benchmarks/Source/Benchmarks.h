@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Created: 18 Oct 2026 10:31:47pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/TraceRecorder.h"
+
+
+///the axes of one run, every list can be narrowed down from the command line
+struct BenchmarkSettings {
+   #if LFOTOOL_TRACE
+    juce::StringArray modes { "free", "sync", "sidechain", "pan", "multiband", "filter", "trace" };
+   #else
+    juce::StringArray modes { "free", "sync", "sidechain", "pan", "multiband", "filter" };
+   #endif
+    juce::Array<int> blockSizes { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048 };
+    juce::Array<int> channelCounts { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    juce::Array<int> nodeCounts { 2, 16, 128, 1024, 2000 };
+    double sampleRate = 48000.0;
+    double secondsPerCase = 0.05;
+
+    //scaling run, this many instances are processed every host cycle, spread over each of the thread counts
+    //no thread counts means 1, 2, 4 ... up to the number of logical cores
+    int instances = 128;
+    juce::Array<int> threadCounts;
+    bool editorWrites = false;      //a thread keeps calling the editor's setters on every instance meanwhile
+};
+
+///one result line, perSample is false for things that are measured per call (table generation)
+struct BenchmarkResult {
+    juce::String benchmark;
+    juce::String mode;
+    int blockSize = 0;
+    int channels = 0;
+    int nodes = 0;
+    bool perSample = true;
+    double nsMedian = 0.0;
+    double nsMin = 0.0;
+    double cyclesMedian = 0.0;  //negative where there is no cycle counter
+    int threads = 0;            //scaling run only, ns are wall time per sample of one instance
+    int instances = 0;
+    double speedup = 0.0;       //throughput relative to the first thread count
+};
+
+///times the modulation and gain hot paths in isolation and through processBlock, and how processBlock
+///scales when many instances run on a host's worker threads
+///ns come from the high resolution clock, cycles from the time stamp counter, which ticks at
+///the nominal clock and not the boosted one, so compare cycles only between runs on the same machine
+class Benchmarks {
+
+private:
+
+    BenchmarkSettings settings;
+    std::vector<BenchmarkResult> results;
+
+    ///runs run() in batches of samplesPerRun until the time budget is used, median and min over the batches
+    template <typename Function>
+    void measure(BenchmarkResult& result, juce::int64 samplesPerRun, Function&& run) const;
+
+    void benchmarkModulationValue(int nodes);
+    void benchmarkGenerate(int nodes);
+    void benchmarkTraceScope();
+    void benchmarkProcessBlock(const juce::String& mode, int channels, int nodes);
+    void benchmarkScaling(const juce::String& mode, int channels, int nodes, int blockSize);
+
+public:
+
+    explicit Benchmarks(const BenchmarkSettings& settings);
+
+    void run(std::function<void(const BenchmarkResult&)> onResult);
+    void runScaling(std::function<void(const BenchmarkResult&)> onResult);
+    juce::var toJson(const juce::String& label) const;
+};
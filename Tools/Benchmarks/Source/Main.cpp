@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 10:29:15pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Benchmarks.h"
+
+namespace {
+
+juce::Array<int> parseIntList(const juce::String& text) {
+    juce::Array<int> values;
+    for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+        if (token.getIntValue() > 0)
+            values.add(token.getIntValue());
+
+    if (values.isEmpty())
+        juce::ConsoleApplication::fail("Expected a comma separated list of positive numbers, got " + text);
+    return values;
+}
+
+void applyOptions(const juce::ArgumentList& args, BenchmarkSettings& settings) {
+    if (args.containsOption("--modes")) {
+        settings.modes = juce::StringArray::fromTokens(args.getValueForOption("--modes"), ",", "");
+        for (auto& mode : settings.modes)
+            if (!BenchmarkSettings().modes.contains(mode))
+                juce::ConsoleApplication::fail("Unknown mode " + mode);
+    }
+    if (args.containsOption("--block-sizes"))
+        settings.blockSizes = parseIntList(args.getValueForOption("--block-sizes"));
+    if (args.containsOption("--channels"))
+        settings.channelCounts = parseIntList(args.getValueForOption("--channels"));
+    if (args.containsOption("--nodes"))
+        settings.nodeCounts = parseIntList(args.getValueForOption("--nodes"));
+    if (args.containsOption("--seconds"))
+        settings.secondsPerCase = juce::jmax(0.001, args.getValueForOption("--seconds").getDoubleValue());
+}
+
+juce::File getOutputFile(const juce::ArgumentList& args) {
+    return args.containsOption("--output") ? args.getFileForOption("--output")
+                                           : juce::File::getCurrentWorkingDirectory().getChildFile("benchmarks.json");
+}
+
+void runBenchmarks(const juce::ArgumentList& args) {
+    BenchmarkSettings settings;
+    applyOptions(args, settings);
+
+    const auto output = getOutputFile(args);
+    const auto label = args.getValueForOption("--label");
+
+    Benchmarks benchmarks(settings);
+    benchmarks.run([](const BenchmarkResult& result) {
+        std::cout << result.benchmark
+                  << (result.mode.isNotEmpty() ? " " + result.mode : juce::String())
+                  << (result.blockSize > 0 ? " block " + juce::String(result.blockSize) : juce::String())
+                  << (result.channels > 0 ? " ch " + juce::String(result.channels) : juce::String())
+                  << " nodes " << result.nodes << ": "
+                  << juce::String(result.nsMedian, 2) << " ns/" << (result.perSample ? "sample" : "call")
+                  << (result.cyclesMedian >= 0.0 ? ", " + juce::String(result.cyclesMedian, 2) + " cycles" : juce::String())
+                  << std::endl;
+    });
+
+    if (!output.replaceWithText(juce::JSON::toString(benchmarks.toJson(label))))
+        juce::ConsoleApplication::fail("Couldn't write " + output.getFullPathName());
+    std::cout << "Results written to " << output.getFullPathName() << std::endl;
+}
+
+void runScaling(const juce::ArgumentList& args) {
+    ///narrower defaults than the full run, every case here creates all the instances
+    BenchmarkSettings settings;
+    settings.modes = { "free" };
+    settings.blockSizes = { 128 };
+    settings.channelCounts = { 2 };
+    settings.nodeCounts = { 128 };
+    settings.secondsPerCase = 1.0;
+    applyOptions(args, settings);
+
+    if (args.containsOption("--instances"))
+        settings.instances = args.getValueForOption("--instances").getIntValue();
+    if (settings.instances <= 0)
+        juce::ConsoleApplication::fail("--instances has to be positive");
+    if (args.containsOption("--threads"))
+        settings.threadCounts = parseIntList(args.getValueForOption("--threads"));
+    settings.editorWrites = args.containsOption("--editor-writes");
+
+    const auto output = getOutputFile(args);
+    const auto label = args.getValueForOption("--label");
+
+    Benchmarks benchmarks(settings);
+    benchmarks.runScaling([&settings](const BenchmarkResult& result) {
+        //how many instances this throughput keeps in realtime, and the speedup per thread
+        const double realtimeInstances = 1.0e9 / (result.nsMedian * settings.sampleRate);
+        std::cout << result.mode << " block " << result.blockSize << " ch " << result.channels << " nodes " << result.nodes
+                  << ", " << result.instances << " instances on " << result.threads << " threads: "
+                  << juce::String(result.nsMedian, 2) << " ns/sample, " << juce::String(realtimeInstances, 1) << " instances in realtime, "
+                  << juce::String(result.speedup, 2) << "x, " << juce::String(result.speedup / result.threads * 100.0, 1) << "% per thread"
+                  << std::endl;
+    });
+
+    if (!output.replaceWithText(juce::JSON::toString(benchmarks.toJson(label))))
+        juce::ConsoleApplication::fail("Couldn't write " + output.getFullPathName());
+    std::cout << "Results written to " << output.getFullPathName() << std::endl;
+}
+
+} //namespace
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage: Benchmarks [options]", true);
+
+    app.addDefaultCommand({ "--run",
+                            "--run [--modes=free,sync,sidechain,pan,multiband,filter] [--block-sizes=1,64,2048] [--channels=1,2] "
+                            "[--nodes=2,2000] [--seconds=0.05] [--output=benchmarks.json] [--label=commit]",
+                            "Measures getModulationValue, generateModulationValues, a trace scope and processBlock.",
+                            "Reports the median ns and cycles per sample (per call for table generation and trace scopes) over several batches "
+                            "for every combination of mode, block size, main input channel count and node count. "
+                            "Channel counts the plugin doesn't accept as its main input are skipped. "
+                            "multiband runs the free mode split into four bands, the difference to free is the crossover "
+                            "and the three extra table reads per sample. filter runs the free mode into the cutoff instead of the gain. "
+                            "traceScope is the cost of one trace event, with and without the recorder running. "
+                            "The trace mode is free with the recorder running and only exists in the Trace configuration "
+                            "(LFOTOOL_TRACE=1), next to free it is what the scopes in processBlock cost. "
+                            "The results are written as json, --label is stored with them, e.g. the commit hash.",
+                            runBenchmarks });
+
+    app.addCommand({ "--scaling",
+                     "--scaling [--instances=128] [--threads=1,2,4,8] [--editor-writes] [--modes=free] [--block-sizes=128] "
+                     "[--channels=2] [--nodes=128] [--seconds=1] [--output=benchmarks.json] [--label=commit]",
+                     "Runs many processor instances concurrently the way a multi-threaded host does.",
+                     "Every host cycle processes one block of every instance, the instances are handed out to the threads "
+                     "through an atomic counter. Reports the wall time per sample of one instance, how many instances that "
+                     "keeps in realtime and the speedup over the first thread count, which should stay close to the thread "
+                     "count as long as there are cores for them. Without --threads it runs 1, 2, 4 ... up to all logical cores. "
+                     "--editor-writes adds a thread that keeps calling the editor's setters on every instance, to show "
+                     "cache lines shared between the editor and the audio thread.",
+                     runScaling });
+
+    return app.findAndRunCommand(argc, argv);
+}
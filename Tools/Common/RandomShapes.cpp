@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    RandomShapes.cpp
+    Created: 18 Oct 2026 10:54:03pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "RandomShapes.h"
+#include <algorithm>
+
+void RandomShapes::layout(ShapeGraph& graph, int width, int height) {
+    const int margin = 10;
+    graph.setWidth(width);
+    graph.setHeight(height);
+    graph.setLeftBound(margin);
+    graph.setRightBound(margin + width);
+    graph.setTopBound(margin);
+    graph.setBottomBound(margin + height);
+    graph.resizeNodeLayout();
+}
+
+void RandomShapes::fill(ShapeGraph& graph, int numNodes, juce::Random& random, bool mixedTypes) {
+    ///goes through restoreLayout, adding thousands of nodes one by one would resort the graph every time
+    numNodes = juce::jmax(2, numNodes);
+    const float nodeSize = (float) graph.getNodeSize();
+    const float left = (float) graph.getLeftBound();
+    const float right = (float) graph.getRightBound();
+    const float top = (float) graph.getTopBound();
+    const float bottom = (float) graph.getBottomBound();
+
+    std::vector<float> centresX((size_t) numNodes);
+    centresX.front() = left;
+    centresX.back() = right;
+    for (int i = 1; i < numNodes - 1; ++i)
+        centresX[(size_t) i] = left + random.nextFloat() * (right - left);
+    std::sort(centresX.begin(), centresX.end());
+
+    std::vector<juce::Point<float>> nodePositions;
+    std::vector<float> centresY;
+    for (float centreX : centresX) {
+        const float centreY = top + nodeSize / 2 + random.nextFloat() * (bottom - top - nodeSize);
+        nodePositions.push_back({ centreX - nodeSize / 2, centreY - nodeSize / 2 });
+        centresY.push_back(centreY);
+    }
+
+    //handles stay inside the graph vertically and between their nodes horizontally
+    std::vector<juce::Point<float>> edgeDeviations;
+    std::vector<SegmentType> edgeTypes;
+    for (size_t i = 0; i + 1 < centresX.size(); ++i) {
+        const float span = centresX[i + 1] - centresX[i];
+        const float xDeviation = (random.nextFloat() - 0.5f) * 0.5f * span;
+        const float midY = (centresY[i] + centresY[i + 1] - nodeSize) / 2;
+        const float handleY = top + random.nextFloat() * (bottom - top - nodeSize);
+        edgeDeviations.push_back({ xDeviation, handleY - midY });
+        edgeTypes.push_back(mixedTypes ? (SegmentType) random.nextInt(SegmentShapes::numTypes) : SegmentType::Curve);
+    }
+
+    graph.restoreLayout(nodePositions, edgeDeviations, edgeTypes);
+}
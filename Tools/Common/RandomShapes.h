@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    RandomShapes.h
+    Created: 18 Oct 2026 10:54:03pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "../../Source/ShapeGraph.h"
+
+
+///builds shapes for the command line tools, reproducible from the seed of the given random
+namespace RandomShapes {
+
+    //the graph area of the editor at its default size
+    constexpr int defaultWidth = 680;
+    constexpr int defaultHeight = 370;
+
+    ///set the bounds the same way the editor does, without a component
+    void layout(ShapeGraph& graph, int width = defaultWidth, int height = defaultHeight);
+
+    ///replace the graph with numNodes nodes (corners included) at random positions and random handles
+    ///with mixedTypes the edges get random segment types, otherwise they stay curves
+    void fill(ShapeGraph& graph, int numNodes, juce::Random& random, bool mixedTypes = true);
+}
@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+    CurveCheck.cpp
+    Created: 19 Oct 2026 2:31:18pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "CurveCheck.h"
+#include "../../Common/RandomShapes.h"
+
+namespace {
+    //how far float geometry may move a segment end, createSegments also widens zero width segments by 1e-5
+    constexpr double positionSlack = 2.0e-5;
+}
+
+CurveCheck::CurveCheck(const CurveCheckSettings& settings) : settings(settings) {
+    ///values are 0..1, float arithmetic stays far below 1e-4, the compiler has to hand out exactly what the builder made
+    results[table]       = { "table builder", 1.0e-4 };
+    results[compiler]    = { "compiler (pool, cache)", 0.0 };
+    results[scalarRead]  = { "scalar read", 1.0e-4 };
+    results[blockRender] = { "block render", 1.0e-4 };
+    results[mipLevels]   = { "mip levels", 1.0e-4 };
+    results[mipRead]     = { "mip read", 1.0e-4 };
+    results[mipBandLimit] = { "mip read band limit", 1.0e-4 };
+    results[shaper]      = { "shaper (vector ops)", 1.0e-4 };
+}
+
+juce::Result CurveCheck::run(std::ostream& log) {
+    Modulator modulator;
+    ShapeCompiler shapeCompiler({ &modulator });
+
+    const int resolution = modulator.getResolution();
+    cosTable.resize((size_t) resolution);
+    sinTable.resize((size_t) resolution);
+    for (int i = 0; i < resolution; ++i) {
+        cosTable[(size_t) i] = std::cos(juce::MathConstants<double>::twoPi * i / resolution);
+        sinTable[(size_t) i] = std::sin(juce::MathConstants<double>::twoPi * i / resolution);
+    }
+
+    for (int shapeIndex = 0; shapeIndex < settings.numShapes; ++shapeIndex) {
+        checkShape(shapeIndex, modulator, shapeCompiler);
+        if ((shapeIndex + 1) % 500 == 0)
+            log << shapeIndex + 1 << " shapes" << std::endl;
+    }
+
+    int numFailed = 0;
+    for (auto& result : results) {
+        const bool failed = !(result.maxError <= result.tolerance);
+        log << result.path << ": max error " << result.maxError << " (tolerance " << result.tolerance << ")";
+        if (result.worstShape >= 0)
+            log << " on shape " << result.worstShape;
+        log << (failed ? ", FAILED" : ", ok") << std::endl;
+        numFailed += failed ? 1 : 0;
+    }
+
+    if (numFailed > 0)
+        return juce::Result::fail(juce::String(numFailed) + " paths differ from the reference, rerun with --seed="
+                                  + juce::String(settings.seed) + " to reproduce");
+    return juce::Result::ok();
+}
+
+void CurveCheck::addError(Path path, double error, int shapeIndex) {
+    auto& result = results[path];
+    //NaN counts as the worst error
+    if (!(error <= result.maxError)) {
+        result.maxError = std::isnan(error) ? std::numeric_limits<double>::infinity() : error;
+        result.worstShape = shapeIndex;
+    }
+}
+
+void CurveCheck::checkShape(int shapeIndex, Modulator& modulator, ShapeCompiler& shapeCompiler) {
+    juce::Random random(settings.seed * 1000003 + shapeIndex);
+
+    ShapeGraph graph;
+    RandomShapes::layout(graph);
+    const int numNodes = shapeIndex % 100 == 99 ? 2000 : 2 + random.nextInt(juce::jmax(1, settings.maxNodes - 1));
+    RandomShapes::fill(graph, numNodes, random);
+
+    const ReferenceCurve reference(graph);
+    const int resolution = modulator.getResolution();
+    const double step = 1.0 / (resolution - 1);
+
+    ///table builder, entry i sits at i / (resolution - 1)
+    const auto segments = Modulator::createSegments(&graph);
+    ModulationTable built(resolution);
+    modulator.fillModulationValues(segments, built);
+    for (int i = 0; i < resolution; ++i) {
+        const double x = i * step;
+        addError(table, reference.getError(built.values[(size_t) i], x - positionSlack, x + positionSlack), shapeIndex);
+    }
+
+    ///the compiler reuses pool tables and serves repeated shapes from its cache, what it publishes has to match a fresh build
+    shapeCompiler.compileNow(segments);
+    auto published = modulator.getTable();
+    if (published == nullptr || published->values.size() != built.values.size()) {
+        addError(compiler, std::numeric_limits<double>::infinity(), shapeIndex);
+        return;
+    }
+    for (int i = 0; i < resolution; ++i)
+        addError(compiler, std::abs(published->values[(size_t) i] - built.values[(size_t) i]), shapeIndex);
+
+    ///scalar read at mip 0 picks entry floor(phase * resolution), so it is up to about one entry off in x
+    const double readSlack = 2.0 / resolution + positionSlack;
+    for (int i = 0; i < 1024; ++i) {
+        const float phase = random.nextFloat();
+        const float value = modulator.getModulationValue(phase);
+        addError(scalarRead, reference.getError(value, phase - readSlack, phase + readSlack), shapeIndex);
+    }
+
+    ///block render accumulates the phase itself, the same accumulation is repeated here in double
+    {
+        constexpr int numSamples = 512;
+        float rendered[numSamples];
+        const double startPhase = random.nextDouble();
+        const double increment = 1.0e-4 + random.nextDouble() * 0.01;
+        modulator.renderModulation(rendered, numSamples, startPhase, increment, 0.0f);
+
+        double phase = startPhase;
+        for (int i = 0; i < numSamples; ++i) {
+            const float readPhase = (float) phase;
+            addError(blockRender, reference.getError(rendered[i], readPhase - readSlack, readPhase + readSlack), shapeIndex);
+            phase += increment;
+            if (phase >= 1.0)
+                phase -= 1.0;
+        }
+    }
+
+    ///the vector shaper interpolates between two entries, so the value is somewhere between the curve at both
+    {
+        constexpr int numSamples = 512;
+        float samples[numSamples], scratch[numSamples];
+        for (auto& sample : samples)
+            sample = random.nextFloat() * 2.4f - 1.2f;
+        float inputs[numSamples];
+        std::copy(std::begin(samples), std::end(samples), inputs);
+
+        modulator.shapeBlock(samples, scratch, numSamples, 1.0f);
+
+        for (int i = 0; i < numSamples; ++i) {
+            //the float index math can land on the neighbouring entry right at an entry
+            const double position = juce::jlimit(0.0, resolution - 1.0 - 1.0e-3, (inputs[i] + 1.0) * 0.5 * (resolution - 1));
+            const double left = std::floor(position - 1.0e-3) * step;
+            const double right = (std::floor(position + 1.0e-3) + 1.0) * step;
+            const double shaped = (samples[i] + 1.0) * 0.5;
+            addError(shaper, reference.getError(shaped, left - positionSlack, right + positionSlack), shapeIndex);
+        }
+    }
+
+    ///band-limited levels against an exact DFT of the same table, and the interpolating read on top of them
+    if (shapeIndex % juce::jmax(1, settings.mipInterval) != 0)
+        return;
+
+    buildReferenceMipLevels(published->values);
+    for (int level = 1; level < ModulationTable::numMipLevels; ++level)
+        for (int i = 0; i < resolution; ++i)
+            addError(mipLevels, std::abs(published->mipLevels[(size_t) level][(size_t) i] - referenceMipLevels[(size_t) level][(size_t) i]), shapeIndex);
+
+    ///the read against the exact curve at the band limit its fractional level implies, only what goes beyond
+    ///the allowance counts as error, so the check doesn't depend on which level readTable picks
+    for (int i = 0; i < 1024; ++i) {
+        const float phase = random.nextFloat();
+        //above 0, level 0 exactly is the plain scalar read
+        const float mipLevel = 1.0e-3f + random.nextFloat() * (ModulationTable::numMipLevels - 1 - 1.0e-3f);
+        bool hardEdge;
+        const float value = modulator.readTable(*published, phase, mipLevel, hardEdge);
+        const double error = std::abs(value - readReferenceMip(phase, mipLevel)) - getMipReadAllowance(mipLevel);
+        addError(mipRead, juce::jmax(0.0, error), shapeIndex);
+    }
+
+    ///a full cycle of reads at one level has no harmonic above the band limit, at any offset between the entries
+    for (int i = 0; i < 2; ++i)
+        checkBandLimit(modulator, *published, 1.0e-3f + random.nextFloat() * (ModulationTable::numMipLevels - 1 - 1.0e-3f),
+                       random.nextDouble(), shapeIndex);
+}
+
+void CurveCheck::buildReferenceMipLevels(const std::vector<float>& values) {
+    ///level l keeps the harmonics up to resolution >> (l + 1), everything above and its mirror is cleared
+    ///the spectrum goes up to half the resolution, the read reference needs it at any fractional level
+    const int resolution = (int) values.size();
+
+    spectrumReal.assign((size_t) resolution / 2 + 1, 0.0);
+    spectrumImag.assign((size_t) resolution / 2 + 1, 0.0);
+    auto& real = spectrumReal;
+    auto& imag = spectrumImag;
+    for (int harmonic = 0; harmonic <= resolution / 2; ++harmonic) {
+        for (int n = 0; n < resolution; ++n) {
+            const int index = (int) (((juce::int64) harmonic * n) % resolution);
+            real[(size_t) harmonic] += values[(size_t) n] * cosTable[(size_t) index];
+            imag[(size_t) harmonic] -= values[(size_t) n] * sinTable[(size_t) index];
+        }
+    }
+
+    referenceMipLevels.resize(ModulationTable::numMipLevels);
+    for (int level = 1; level < ModulationTable::numMipLevels; ++level) {
+        const int levelHarmonic = resolution >> (level + 1);
+        auto& levelValues = referenceMipLevels[(size_t) level];
+        levelValues.assign((size_t) resolution, 0.0);
+        for (int n = 0; n < resolution; ++n) {
+            double sum = real[0];
+            for (int harmonic = 1; harmonic <= levelHarmonic; ++harmonic) {
+                const int index = (int) (((juce::int64) harmonic * n) % resolution);
+                sum += 2.0 * (real[(size_t) harmonic] * cosTable[(size_t) index] - imag[(size_t) harmonic] * sinTable[(size_t) index]);
+            }
+            levelValues[(size_t) n] = sum / resolution;
+        }
+    }
+}
+
+int CurveCheck::getBandLimit(float mipLevel) const {
+    ///level l halves the harmonics l + 1 times, a fractional level sits between two of those limits
+    const int resolution = (int) cosTable.size();
+    return (int) std::floor(resolution / std::exp2((double) mipLevel + 1.0));
+}
+
+double CurveCheck::getMipReadAllowance(float mipLevel) const {
+    const int resolution = (int) cosTable.size();
+    const int limit = getBandLimit(mipLevel);
+    double allowance = 0.0;
+    for (int harmonic = 1; harmonic <= limit; ++harmonic) {
+        const double amplitude = 2.0 * std::hypot(spectrumReal[(size_t) harmonic], spectrumImag[(size_t) harmonic]) / resolution;
+        if (2 * harmonic > limit)
+            allowance += amplitude;
+        //linear interpolation of a sine of this harmonic is off by at most (h * omega)^2 / 8 of its amplitude
+        const double omega = juce::MathConstants<double>::twoPi * harmonic / resolution;
+        allowance += amplitude * omega * omega / 8.0;
+    }
+    return allowance;
+}
+
+double CurveCheck::readReferenceMip(double phase, float mipLevel) const {
+    ///the Fourier series of the table up to the band limit, evaluated at the exact phase instead of between entries
+    const int resolution = (int) cosTable.size();
+    const int limit = getBandLimit(mipLevel);
+    double sum = spectrumReal[0];
+    for (int harmonic = 1; harmonic <= limit; ++harmonic) {
+        const double angle = juce::MathConstants<double>::twoPi * harmonic * phase;
+        sum += 2.0 * (spectrumReal[(size_t) harmonic] * std::cos(angle) - spectrumImag[(size_t) harmonic] * std::sin(angle));
+    }
+    return sum / resolution;
+}
+
+void CurveCheck::checkBandLimit(const Modulator& modulator, const ModulationTable& table, float mipLevel, double offset, int shapeIndex) {
+    ///reads one cycle at the table's own spacing shifted by offset entries, the largest harmonic amplitude above the limit is the error
+    const int resolution = (int) cosTable.size();
+    std::vector<double> cycle((size_t) resolution);
+    for (int n = 0; n < resolution; ++n) {
+        bool hardEdge;
+        cycle[(size_t) n] = modulator.readTable(table, (float) ((n + offset) / resolution), mipLevel, hardEdge);
+    }
+
+    for (int harmonic = getBandLimit(mipLevel) + 1; harmonic <= resolution / 2; ++harmonic) {
+        double real = 0.0, imag = 0.0;
+        for (int n = 0; n < resolution; ++n) {
+            const int index = (int) (((juce::int64) harmonic * n) % resolution);
+            real += cycle[(size_t) n] * cosTable[(size_t) index];
+            imag -= cycle[(size_t) n] * sinTable[(size_t) index];
+        }
+        addError(mipBandLimit, 2.0 * std::hypot(real, imag) / resolution, shapeIndex);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    CurveCheck.h
+    Created: 19 Oct 2026 2:31:18pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../../Source/ShapeCompiler.h"
+#include "ReferenceCurve.h"
+
+
+struct CurveCheckSettings {
+    int numShapes = 2000;
+    int maxNodes = 64;          //every 100th shape has 2000 nodes on top
+    int mipInterval = 16;       //the band-limit reference is a plain DFT, only every n-th shape gets it
+    juce::int64 seed = 1;
+};
+
+///compares everything that turns a ShapeGraph into modulation values against ReferenceCurve on random shapes:
+///the table builder, the compiler's pooled and cached tables, the scalar read, the block renderer, the band-limited
+///levels and their read, and the vectorized shaper. every path has its own tolerance, the report gives the
+///largest error per path and the shape it happened on, a shape is reproducible from the seed and its index
+class CurveCheck {
+
+public:
+
+    struct PathResult {
+        juce::String path;
+        double tolerance;
+        double maxError = 0.0;
+        int worstShape = -1;
+    };
+
+    explicit CurveCheck(const CurveCheckSettings& settings);
+
+    ///prints one line per path, fails if any error is above its tolerance
+    juce::Result run(std::ostream& log);
+
+private:
+
+    enum Path { table, compiler, scalarRead, blockRender, mipLevels, mipRead, mipBandLimit, shaper, numPaths };
+
+    CurveCheckSettings settings;
+    std::array<PathResult, numPaths> results;
+
+    //double precision band-limited copies of a table, built the same way buildMipLevels does with an exact DFT,
+    //and the spectrum they come from, up to half the resolution
+    std::vector<std::vector<double>> referenceMipLevels;
+    std::vector<double> spectrumReal, spectrumImag;
+    std::vector<double> cosTable, sinTable;
+
+    void checkShape(int shapeIndex, Modulator& modulator, ShapeCompiler& shapeCompiler);
+    void buildReferenceMipLevels(const std::vector<float>& values);
+    ///the harmonics a read at this mip level may keep, derived from the level alone
+    int getBandLimit(float mipLevel) const;
+    ///how far a correct read may be from the exact band-limited curve: it may drop the upper half of the allowed
+    ///harmonics (the next level down) and linear interpolation between the entries bends the rest
+    double getMipReadAllowance(float mipLevel) const;
+    double readReferenceMip(double phase, float mipLevel) const;
+    void checkBandLimit(const Modulator& modulator, const ModulationTable& table, float mipLevel, double offset, int shapeIndex);
+    void addError(Path path, double error, int shapeIndex);
+};
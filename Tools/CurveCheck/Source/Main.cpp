@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 2:02:47pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "CurveCheck.h"
+
+namespace {
+
+void checkCurves(const juce::ArgumentList& args) {
+    CurveCheckSettings settings;
+    if (args.containsOption("--shapes"))
+        settings.numShapes = args.getValueForOption("--shapes").getIntValue();
+    if (args.containsOption("--max-nodes"))
+        settings.maxNodes = args.getValueForOption("--max-nodes").getIntValue();
+    if (args.containsOption("--mip-interval"))
+        settings.mipInterval = args.getValueForOption("--mip-interval").getIntValue();
+    if (args.containsOption("--seed"))
+        settings.seed = args.getValueForOption("--seed").getLargeIntValue();
+
+    if (settings.numShapes <= 0 || settings.maxNodes < 2 || settings.mipInterval <= 0)
+        juce::ConsoleApplication::fail("--shapes and --mip-interval have to be positive, --max-nodes at least 2");
+
+    auto result = CurveCheck(settings).run(std::cout);
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+}
+
+} //namespace
+
+int main(int argc, char* argv[]) {
+    ///no window is opened, the initialiser is only there for the compiler thread and the message manager asserts
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage: CurveCheck [options]", true);
+
+    app.addDefaultCommand({ "--run",
+                            "--run [--shapes=2000] [--max-nodes=64] [--mip-interval=16] [--seed=1]",
+                            "Compares every curve evaluation path against a double precision reference.",
+                            "Builds random shapes with mixed segment types and checks the table builder, the compiler's pooled "
+                            "and cached tables, the scalar read, the block renderer, the band-limited levels and the vector shaper "
+                            "against ReferenceCurve. The band-limited read is compared with the exact Fourier series at the band "
+                            "limit its mip level implies, and a full cycle of it must not have harmonics above that limit. Prints the largest error per path and the shape it "
+                            "happened on and fails if any path is above its tolerance. The same seed gives the same shapes.",
+                            checkCurves });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    ReferenceCurve.cpp
+    Created: 19 Oct 2026 2:05:33pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "ReferenceCurve.h"
+
+ReferenceCurve::ReferenceCurve(const ShapeGraph& graph) {
+    ///same normalisation as the table, the graph bounds map to 0..1 and y points up
+    const double minX = graph.getLeftBound();
+    const double minY = graph.getTopBound();
+    const double width = graph.getRightBound() - minX;
+    const double height = graph.getBottomBound() - minY;
+
+    auto normaliseX = [&](const juce::Rectangle<float>& rect) { return ((double) rect.getCentreX() - minX) / width; };
+    auto normaliseY = [&](const juce::Rectangle<float>& rect) { return 1.0 - ((double) rect.getCentreY() - minY) / height; };
+
+    for (auto* edge : graph.edges) {
+        const auto& from = graph.nodes[edge->from]->rect;
+        const auto& to = graph.nodes[edge->to]->rect;
+
+        Segment segment;
+        segment.x0 = normaliseX(from);
+        segment.x2 = normaliseX(to);
+        segment.y0 = normaliseY(from);
+        segment.y1 = normaliseY(edge->rect);
+        segment.y2 = normaliseY(to);
+        segment.type = edge->type;
+
+        //the thresholds are part of the definition, see SegmentShapes::tensionFromHandle
+        const double range = segment.y2 - segment.y0;
+        segment.tension = std::abs(range) < 1e-4 ? 0.0 : juce::jlimit(-1.0, 1.0, (2.0 * segment.y1 - segment.y0 - segment.y2) / range);
+        segments.push_back(segment);
+    }
+
+    //the graph keeps its nodes sorted by x, so segment ends never decrease and the lookups can bisect
+    jassert(std::is_sorted(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.x2 < b.x2; }));
+}
+
+double ReferenceCurve::evaluate(const Segment& segment, double alpha) {
+    const double y0 = segment.y0, y1 = segment.y1, y2 = segment.y2;
+    const double inv = 1.0 - alpha;
+
+    switch (segment.type) {
+        case SegmentType::Hold:
+            return alpha < 1.0 ? y0 : y2;
+
+        case SegmentType::Linear:
+            return y0 + (y2 - y0) * alpha;
+
+        case SegmentType::Exponential: {
+            const double k = -8.0 * segment.tension;
+            if (std::abs(k) < 1e-3)
+                return y0 + (y2 - y0) * alpha;
+            return y0 + (y2 - y0) * std::expm1(k * alpha) / std::expm1(k);
+        }
+
+        case SegmentType::Cubic:
+            //both inner control points on the handle
+            return inv * inv * inv * y0 + 3.0 * inv * inv * alpha * y1 + 3.0 * inv * alpha * alpha * y1 + alpha * alpha * alpha * y2;
+
+        case SegmentType::SCurve: {
+            const double power = std::exp2(3.0 * segment.tension);
+            const double a = std::pow(alpha, power);
+            const double b = std::pow(inv, power);
+            return y0 + (y2 - y0) * (a + b > 0.0 ? a / (a + b) : alpha);
+        }
+
+        case SegmentType::Curve:
+        default:
+            return inv * inv * y0 + 2.0 * inv * alpha * y1 + alpha * alpha * y2;
+    }
+}
+
+double ReferenceCurve::evaluateAt(const Segment& segment, double x) {
+    const double width = segment.x2 - segment.x0;
+    const double alpha = width > 0.0 ? juce::jlimit(0.0, 1.0, (x - segment.x0) / width) : 1.0;
+    return juce::jlimit(0.0, 1.0, evaluate(segment, alpha));
+}
+
+const ReferenceCurve::Segment* ReferenceCurve::findSegment(double x) const {
+    ///the first segment containing x, every segment before it ends left of x
+    auto segment = getFirstSegmentEndingAfter(x);
+    if (segment != segments.end() && segment->x0 <= x)
+        return &*segment;
+    return nullptr;
+}
+
+std::vector<ReferenceCurve::Segment>::const_iterator ReferenceCurve::getFirstSegmentEndingAfter(double x) const {
+    return std::lower_bound(segments.begin(), segments.end(), x, [](const Segment& segment, double value) { return segment.x2 < value; });
+}
+
+double ReferenceCurve::getValue(double x) const {
+    const auto* segment = findSegment(x);
+    return segment != nullptr ? evaluateAt(*segment, x) : 0.0;
+}
+
+juce::Range<double> ReferenceCurve::getRange(double start, double end) const {
+    start = juce::jlimit(0.0, 1.0, start);
+    end = juce::jlimit(start, 1.0, end);
+
+    double low = getValue(start), high = low;
+    auto include = [&](double value) {
+        low = juce::jmin(low, value);
+        high = juce::jmax(high, value);
+    };
+    auto probe = [&](double x) {
+        if (x >= start && x <= end)
+            include(getValue(x));
+    };
+
+    ///evenly spaced probes for the smooth parts, both sides of every segment end for the jumps
+    constexpr int numProbes = 16;
+    for (int i = 1; i <= numProbes; ++i)
+        probe(start + (end - start) * i / numProbes);
+
+    for (auto segment = getFirstSegmentEndingAfter(start); segment != segments.end() && segment->x0 <= end; ++segment) {
+        for (double x : { segment->x0, segment->x2 }) {
+            probe(x);
+            probe(std::nextafter(x, -1.0));
+            probe(std::nextafter(x, 2.0));
+        }
+
+        if (segment->x0 >= start && segment->x2 <= end) {
+            include(juce::jlimit(0.0, 1.0, juce::jmin(segment->y0, segment->y1, segment->y2)));
+            include(juce::jlimit(0.0, 1.0, juce::jmax(segment->y0, segment->y1, segment->y2)));
+        }
+    }
+
+    return { low, high };
+}
+
+double ReferenceCurve::getError(double value, double start, double end) const {
+    const auto range = getRange(start, end);
+    if (std::isnan(value))
+        return std::numeric_limits<double>::infinity();
+    return juce::jmax(0.0, range.getStart() - value, value - range.getEnd());
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    ReferenceCurve.h
+    Created: 19 Oct 2026 2:05:33pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../../Source/ShapeGraph.h"
+#include "../../../Source/SegmentShapes.h"
+
+
+///slow double precision model of the curve a ShapeGraph describes, built from the nodes and handles directly
+///instead of going through Modulator::createSegments, so it checks the segment extraction as well
+///it follows the definition the table is built with: a segment maps x linearly to alpha and evaluates its
+///closed form at alpha, where segments overlap the earlier one wins, x outside of every segment is 0
+///and the values are clipped to 0..1
+class ReferenceCurve {
+
+private:
+
+    struct Segment {
+        double x0, x2;
+        double y0, y1, y2;
+        double tension;
+        SegmentType type;
+    };
+
+    std::vector<Segment> segments;
+
+    static double evaluate(const Segment& segment, double alpha);
+    static double evaluateAt(const Segment& segment, double x);
+    const Segment* findSegment(double x) const;
+    std::vector<Segment>::const_iterator getFirstSegmentEndingAfter(double x) const;
+
+public:
+
+    explicit ReferenceCurve(const ShapeGraph& graph);
+
+    double getValue(double x) const;
+
+    ///smallest and largest value the curve takes for x in [start, end]
+    ///segments that lie inside the interval count with the hull of their control values,
+    ///which bounds every segment type, so a degenerate segment never makes a correct value look wrong
+    juce::Range<double> getRange(double start, double end) const;
+
+    ///how far value lies outside of getRange(start, end), 0 if inside
+    ///the interval is how much an evaluator may be off in x, from float geometry or reading the nearest table entry
+    double getError(double value, double start, double end) const;
+};
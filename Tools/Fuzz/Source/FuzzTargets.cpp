@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    FuzzTargets.cpp
+    Created: 19 Oct 2026 4:36:12pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/Modulator.h"
+#include "../../../Source/ShapeGraph.h"
+
+///libFuzzer entry points for everything that reads host supplied data, there is no main, libFuzzer brings its own
+///build with clang, the exporter adds -fsanitize=fuzzer,address,undefined:
+///    make CXX=clang++ CONFIG=Release
+///and run with a time and memory budget per input, any input that takes longer counts as a failure:
+///    ./build/Fuzz -timeout=2 -rss_limit_mb=2048 -max_len=65536 ../../Corpus
+///the first byte of an input picks the target, the files in Corpus start with the ascii digit of theirs
+
+namespace {
+
+enum Target { stateBinary, shapeXml, stateXml, numTargets };
+
+constexpr double sampleRate = 44100.0;
+constexpr int blockSize = 64;
+constexpr int numBlocks = 8;
+
+void check(bool condition, const char* message) {
+    if (!condition) {
+        std::fputs(message, stderr);
+        std::fputs("\n", stderr);
+        std::abort();
+    }
+}
+
+///one processor for the whole run, as in a host that keeps loading sessions into the same instance
+struct Fixture {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    RectanglesAudioProcessor processor;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+
+    Modulator modulator;
+    ModulationTable table { modulator.getResolution() };
+    juce::dsp::FFT fft { juce::roundToInt(std::log2(modulator.getResolution())) };
+    std::vector<float> spectrum, scratch;
+
+    Fixture() {
+        processor.prepareToPlay(sampleRate, blockSize);
+        buffer.setSize(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+        spectrum.resize(2 * (size_t) modulator.getResolution());
+        scratch.resize(2 * (size_t) modulator.getResolution());
+    }
+};
+
+Fixture& getFixture() {
+    static Fixture fixture;
+    return fixture;
+}
+
+void processRestoredState(Fixture& fixture) {
+    ///whatever was restored has to produce finite audio, the noise is seeded so a crash reproduces
+    juce::Random random(1);
+    for (int block = 0; block < numBlocks; ++block) {
+        for (int channel = 0; channel < fixture.buffer.getNumChannels(); ++channel)
+            for (int sample = 0; sample < blockSize; ++sample)
+                fixture.buffer.setSample(channel, sample, random.nextFloat() * 2.0f - 1.0f);
+
+        fixture.midi.clear();
+        fixture.processor.processBlock(fixture.buffer, fixture.midi);
+
+        for (int channel = 0; channel < fixture.processor.getTotalNumOutputChannels(); ++channel)
+            for (int sample = 0; sample < blockSize; ++sample)
+                check(std::isfinite(fixture.buffer.getSample(channel, sample)), "restored state produced non-finite output");
+    }
+}
+
+void fuzzStateBinary(Fixture& fixture, const juce::uint8* data, size_t size) {
+    fixture.processor.setStateInformation(data, (int) size);
+    processRestoredState(fixture);
+}
+
+void fuzzStateXml(Fixture& fixture, const juce::uint8* data, size_t size) {
+    ///wraps the input the way copyXmlToBinary does, so the mutations land in the xml instead of the header
+    constexpr juce::uint32 magicXmlNumber = 0x21324356;
+    juce::MemoryOutputStream stream;
+    stream.writeInt((int) magicXmlNumber);
+    stream.writeInt((int) size);
+    stream.write(data, size);
+    stream.writeByte(0);
+
+    fixture.processor.setStateInformation(stream.getData(), (int) stream.getDataSize());
+    processRestoredState(fixture);
+}
+
+void fuzzShapeXml(Fixture& fixture, const juce::uint8* data, size_t size) {
+    ///the table generation on its own, every entry of every table has to be finite and the values inside 0..1
+    if (size > (size_t) RectanglesAudioProcessor::maxStateSize || !RectanglesAudioProcessor::isStateWithinLimits(data, (int) size))
+        return;
+
+    auto xml = juce::parseXML(juce::String::fromUTF8(reinterpret_cast<const char*>(data), (int) size));
+    if (xml == nullptr)
+        return;
+
+    ShapeGraph shapeGraph;
+    shapeGraph.loadXML(*xml);
+    check(shapeGraph.nodes.size() >= 2 && shapeGraph.nodes.size() <= ShapeGraph::maxNodes, "node count outside 2..maxNodes");
+    check(shapeGraph.edges.size() == shapeGraph.nodes.size() - 1, "edges don't match the nodes");
+
+    auto segments = Modulator::createSegments(&shapeGraph);
+    if (segments.empty())
+        return;
+
+    fixture.modulator.fillModulationValues(segments, fixture.table);
+    fixture.modulator.buildMipLevels(fixture.table, fixture.fft, fixture.spectrum, fixture.scratch);
+
+    for (float value : fixture.table.values)
+        check(value >= 0.0f && value <= 1.0f, "table value outside 0..1");
+    for (int level = 1; level < ModulationTable::numMipLevels; ++level)
+        for (float value : fixture.table.mipLevels[level])
+            check(std::isfinite(value), "non-finite mip level value");
+
+    //and once more through the path the processor uses
+    fixture.processor.loadShapeGraphXml(*xml);
+
+    //the editor lays the graph out before loading and moves the corners on every resize
+    ShapeGraph editorGraph;
+    editorGraph.setWidth(680);
+    editorGraph.setHeight(350);
+    editorGraph.setLeftBound(10);
+    editorGraph.setRightBound(690);
+    editorGraph.setTopBound(30);
+    editorGraph.setBottomBound(380);
+    editorGraph.resizeNodeLayout();
+    editorGraph.loadXML(*xml);
+    editorGraph.resizeNodeLayout();
+    check(editorGraph.edges.size() == editorGraph.nodes.size() - 1, "edges don't match the nodes after the layout");
+    for (auto* node : editorGraph.nodes)
+        check(std::isfinite(node->rect.getX()) && std::isfinite(node->rect.getY()), "non-finite node position after the layout");
+}
+
+} //namespace
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    getFixture();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const juce::uint8* data, size_t size) {
+    if (size == 0)
+        return 0;
+
+    auto& fixture = getFixture();
+    switch ((data[0] - '0' + numTargets * 100) % numTargets) {
+        case stateBinary:
+            fuzzStateBinary(fixture, data + 1, size - 1);
+            break;
+        case shapeXml:
+            fuzzShapeXml(fixture, data + 1, size - 1);
+            break;
+        case stateXml:
+            fuzzStateXml(fixture, data + 1, size - 1);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
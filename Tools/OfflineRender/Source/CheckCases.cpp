@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    CheckCases.cpp
+    Created: 20 Oct 2026 9:12:40am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "CheckCases.h"
+
+std::vector<CheckCases::Case> CheckCases::getProcessingPaths() {
+    std::vector<Case> cases;
+    auto addCase = [&cases](const juce::String& name, std::initializer_list<std::pair<const char*, const char*>> values) {
+        Case testCase { name, {} };
+        for (auto& value : values)
+            testCase.parameterValues.set(value.first, value.second);
+        cases.push_back(testCase);
+    };
+
+    addCase("free", {});
+    addCase("sync", { { "sync", "1" } });
+    addCase("pan offset", { { "pan offset", "0.25" } });
+    addCase("sidechain level", { { "sc", "1" } });
+    addCase("sidechain level sync", { { "sc", "1" }, { "sync", "1" }, { "lfo rate", "4" } });
+    addCase("sidechain transient", { { "sc", "1" }, { "sc trigger", "1" } });
+    addCase("sidechain filter", { { "sc", "1" }, { "sc filter", "3" } });
+    addCase("scrub", { { "sc", "1" }, { "sc mode", "1" } });
+    addCase("multiband", { { "bands", "3" } });
+    addCase("filter", { { "destination", "1" } });
+    addCase("am", { { "mode", "1" }, { "lfo rate", "220" } });
+    addCase("ring", { { "mode", "2" }, { "lfo rate", "220" } });
+    addCase("shaper", { { "mode", "3" } });
+    addCase("cc output", { { "cc output", "1" } });
+    return cases;
+}
+
+void CheckCases::makeSignals(int length, juce::Random& random, juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& sidechain) {
+    input.setSize(2, length);
+    sidechain.setSize(2, length);
+    for (int channel = 0; channel < 2; ++channel) {
+        for (int i = 0; i < length; ++i) {
+            const float burstLevel = 0.2f + 0.1f * (float) ((i / 7013) % 8);
+            input.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+            sidechain.setSample(channel, i, i % 7013 < 701 ? burstLevel * (random.nextFloat() * 2.0f - 1.0f) : 0.0f);
+        }
+    }
+}
+
+juce::Array<int> CheckCases::parseBlockSizes(const juce::ArgumentList& args, const juce::Array<int>& defaults) {
+    if (!args.containsOption("--block-sizes"))
+        return defaults;
+
+    juce::Array<int> blockSizes;
+    for (auto& token : juce::StringArray::fromTokens(args.getValueForOption("--block-sizes"), ",", ""))
+        if (token.getIntValue() > 0)
+            blockSizes.add(token.getIntValue());
+    return blockSizes;
+}
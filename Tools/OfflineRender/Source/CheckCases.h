@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+    CheckCases.h
+    Created: 20 Oct 2026 9:12:40am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+
+///what the realtime and the determinism check have in common, the processing paths they go through,
+///the signals they feed them and how their block sizes are given on the command line
+namespace CheckCases {
+
+    struct Case {
+        juce::String name;
+        juce::StringPairArray parameterValues;
+    };
+
+    ///one case per processing path, the values are in the parameters' own ranges
+    std::vector<Case> getProcessingPaths();
+
+    ///noise on the main input, bursts of varying level on the sidechain so the level and transient triggers fire mid block
+    void makeSignals(int length, juce::Random& random, juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& sidechain);
+
+    ///--block-sizes=1,37,512, the defaults without the option, empty if the option has no positive size
+    juce::Array<int> parseBlockSizes(const juce::ArgumentList& args, const juce::Array<int>& defaults);
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    DeterminismCheck.cpp
+    Created: 19 Oct 2026 10:14:07am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "DeterminismCheck.h"
+#include "../../Common/RandomShapes.h"
+
+DeterminismCheck::DeterminismCheck(juce::Array<int> blockSizes, double seconds, float tolerance)
+    : blockSizes(std::move(blockSizes)), seconds(seconds), tolerance(tolerance), cases(CheckCases::getProcessingPaths()) {
+    for (auto& testCase : cases)
+        testCase.parameterValues.set("deterministic", "1");
+}
+
+juce::Result DeterminismCheck::run(std::ostream& log) const {
+    int numFailed = 0;
+    for (auto& testCase : cases) {
+        juce::AudioBuffer<float> reference;
+        for (int index = 0; index < blockSizes.size(); ++index) {
+            const int blockSize = blockSizes[index];
+            juce::AudioBuffer<float> output;
+            auto result = renderCase(testCase, blockSize, index == 0 ? reference : output);
+            if (result.failed()) {
+                log << testCase.name << ", block " << blockSize << ": " << result.getErrorMessage() << std::endl;
+                ++numFailed;
+                break;
+            }
+            if (index == 0)
+                continue;
+
+            const auto difference = compare(reference, output);
+            log << testCase.name << ", block " << blockSize << " vs " << blockSizes[0] << ": max error " << difference.maxError;
+            if (difference.firstSample >= 0) {
+                log << ", differs from sample " << difference.firstSample << std::endl;
+                ++numFailed;
+            } else {
+                log << ", ok" << std::endl;
+            }
+        }
+    }
+
+    if (numFailed > 0)
+        return juce::Result::fail(juce::String(numFailed) + " renders depend on the block size");
+    return juce::Result::ok();
+}
+
+juce::Result DeterminismCheck::renderCase(const Case& testCase, int blockSize, juce::AudioBuffer<float>& output) const {
+    RenderSettings settings;
+    settings.parameterValues = testCase.parameterValues;
+    OfflineRenderer renderer(settings);
+
+    juce::String error;
+    auto processor = renderer.createProcessor(error);
+    if (processor == nullptr)
+        return juce::Result::fail(error);
+
+    ///the same shapes for every block size, loaded synchronously so no render starts before its tables are in
+    juce::Random shapeRandom(1);
+    ShapeGraph graph;
+    RandomShapes::layout(graph);
+    for (int band = 0; band < RectanglesAudioProcessor::maxBands; ++band) {
+        RandomShapes::fill(graph, 8 + 4 * band, shapeRandom);
+        processor->loadShapeGraphXml(*graph.createXML(), band);
+    }
+
+    ///seeded the same for every block size
+    constexpr double sampleRate = 48000.0;
+    juce::AudioBuffer<float> input, sidechain;
+    juce::Random random(2);
+    CheckCases::makeSignals((int) (seconds * sampleRate), random, input, sidechain);
+
+    return renderer.renderBuffer(*processor, input, &sidechain, sampleRate, blockSize, output);
+}
+
+DeterminismCheck::Difference DeterminismCheck::compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& output) const {
+    Difference difference;
+    if (reference.getNumChannels() != output.getNumChannels() || reference.getNumSamples() != output.getNumSamples()) {
+        difference.maxError = std::numeric_limits<float>::infinity();
+        difference.firstSample = 0;
+        return difference;
+    }
+
+    for (int channel = 0; channel < reference.getNumChannels(); ++channel) {
+        const float* expected = reference.getReadPointer(channel);
+        const float* actual = output.getReadPointer(channel);
+        for (int i = 0; i < reference.getNumSamples(); ++i) {
+            const float error = std::abs(expected[i] - actual[i]);
+            //NaN counts as a difference too
+            if (!(error <= tolerance) && (difference.firstSample < 0 || i < difference.firstSample))
+                difference.firstSample = i;
+            difference.maxError = juce::jmax(difference.maxError, error);
+        }
+    }
+    return difference;
+}
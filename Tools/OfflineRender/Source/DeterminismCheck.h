@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    DeterminismCheck.h
+    Created: 19 Oct 2026 10:14:07am
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "CheckCases.h"
+
+
+///renders the same input through every processing path at several block sizes with the deterministic parameter on
+///and compares the outputs sample by sample against the first block size
+///the shapes are random but fixed and compiled synchronously, so the renders only differ in how the blocks are cut
+class DeterminismCheck {
+
+private:
+
+    using Case = CheckCases::Case;
+
+    struct Difference {
+        float maxError = 0.0f;
+        int firstSample = -1;       //first sample above the tolerance, -1 if none
+    };
+
+    juce::Array<int> blockSizes;
+    double seconds;
+    float tolerance;
+    std::vector<Case> cases;
+
+    juce::Result renderCase(const Case& testCase, int blockSize, juce::AudioBuffer<float>& output) const;
+    Difference compare(const juce::AudioBuffer<float>& reference, const juce::AudioBuffer<float>& output) const;
+
+public:
+
+    DeterminismCheck(juce::Array<int> blockSizes, double seconds, float tolerance);
+
+    ///prints the largest difference per case and block size, fails if any is above the tolerance
+    juce::Result run(std::ostream& log) const;
+};
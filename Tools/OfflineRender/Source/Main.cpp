@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026 9:38:50pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RealtimeCheck.h"
+#include "DeterminismCheck.h"
+#include "CheckCases.h"
+#include "../../../Source/TraceRecorder.h"
+
+namespace {
+
+RenderSettings parseRenderSettings(const juce::ArgumentList& args) {
+    RenderSettings settings;
+
+    if (args.containsOption("--state"))
+        settings.stateFile = args.getExistingFileForOption("--state");
+    if (args.containsOption("--shape"))
+        settings.shapeFile = args.getExistingFileForOption("--shape");
+    if (args.containsOption("--sidechain"))
+        settings.sidechainFile = args.getExistingFileForOption("--sidechain");
+    if (args.containsOption("--output-dir"))
+        settings.outputDirectory = args.getFileForOption("--output-dir");
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+    if (args.containsOption("--bpm"))
+        settings.bpm = args.getValueForOption("--bpm").getDoubleValue();
+
+    if (settings.blockSize <= 0)
+        juce::ConsoleApplication::fail("--block-size has to be positive");
+    if (settings.bpm <= 0.0)
+        juce::ConsoleApplication::fail("--bpm has to be positive");
+
+    ///--param=id:value, may be given more than once
+    for (auto& argument : args.arguments) {
+        if (!argument.isLongOption("param"))
+            continue;
+        auto assignment = argument.getLongOptionValue();
+        if (!assignment.containsChar(':'))
+            juce::ConsoleApplication::fail("--param expects id:value, got " + assignment);
+        settings.parameterValues.set(assignment.upToLastOccurrenceOf(":", false, false),
+                                     assignment.fromLastOccurrenceOf(":", false, false));
+    }
+
+    return settings;
+}
+
+juce::Array<juce::File> getInputFiles(const juce::ArgumentList& args) {
+    juce::Array<juce::File> files;
+    for (auto& argument : args.arguments)
+        if (!argument.isOption())
+            files.add(argument.resolveAsExistingFile());
+
+    if (files.isEmpty())
+        juce::ConsoleApplication::fail("No input files");
+    return files;
+}
+
+void render(const juce::ArgumentList& args) {
+    const auto settings = parseRenderSettings(args);
+    const auto inputs = getInputFiles(args);
+    const int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                            : juce::SystemStats::getNumCpus();
+
+    if (settings.outputDirectory != juce::File() && !settings.outputDirectory.createDirectory())
+        juce::ConsoleApplication::fail("Couldn't create " + settings.outputDirectory.getFullPathName());
+
+    if (args.containsOption("--trace")) {
+       #if LFOTOOL_TRACE
+        auto traceResult = TraceRecorder::getInstance().start(args.getFileForOption("--trace"));
+        if (traceResult.failed())
+            juce::ConsoleApplication::fail(traceResult.getErrorMessage());
+       #else
+        std::cerr << "--trace needs a build with LFOTOOL_TRACE=1, ignored" << std::endl;
+       #endif
+    }
+
+    OfflineRenderer renderer(settings);
+
+    ///every job creates its processor and drops it when the file is done, so there are never more of them than threads
+    std::vector<juce::Result> results((size_t) inputs.size(), juce::Result::ok());
+    {
+        juce::ThreadPool pool(juce::jmax(1, numThreads));
+        juce::WaitableEvent finished;
+        std::atomic<int> remaining { inputs.size() };
+        for (int i = 0; i < inputs.size(); ++i) {
+            pool.addJob([&, i] {
+                juce::String error;
+                if (auto processor = renderer.createProcessor(error))
+                    results[(size_t) i] = renderer.render(*processor, inputs[i], renderer.getOutputFile(inputs[i]));
+                else
+                    results[(size_t) i] = juce::Result::fail(error);
+
+                if (--remaining == 0)
+                    finished.signal();
+            });
+        }
+
+        finished.wait();
+    }
+    TraceRecorder::getInstance().stop();
+
+    int numFailed = 0;
+    for (int i = 0; i < inputs.size(); ++i) {
+        if (results[(size_t) i].wasOk()) {
+            std::cout << inputs[i].getFileName() << " -> " << renderer.getOutputFile(inputs[i]).getFullPathName() << std::endl;
+        } else {
+            std::cerr << results[(size_t) i].getErrorMessage() << std::endl;
+            ++numFailed;
+        }
+    }
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " of " + juce::String(inputs.size()) + " files failed");
+}
+
+void checkRealtime(const juce::ArgumentList& args) {
+    const auto blockSizes = CheckCases::parseBlockSizes(args, { 1, 37, 512 });
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 1.0;
+    if (blockSizes.isEmpty() || seconds <= 0.0)
+        juce::ConsoleApplication::fail("--block-sizes and --seconds have to be positive");
+
+    auto result = RealtimeCheck(blockSizes, seconds).run(std::cout);
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+}
+
+void verifyDeterminism(const juce::ArgumentList& args) {
+    const auto blockSizes = CheckCases::parseBlockSizes(args, { 1, 37, 64, 4096 });
+    const double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 2.0;
+    const float tolerance = args.containsOption("--tolerance") ? args.getValueForOption("--tolerance").getFloatValue() : 0.0f;
+    if (blockSizes.size() < 2 || seconds <= 0.0 || tolerance < 0.0f)
+        juce::ConsoleApplication::fail("--block-sizes needs two sizes, --seconds has to be positive, --tolerance can't be negative");
+
+    auto result = DeterminismCheck(blockSizes, seconds, tolerance).run(std::cout);
+    if (result.failed())
+        juce::ConsoleApplication::fail(result.getErrorMessage());
+}
+
+} //namespace
+
+int main(int argc, char* argv[]) {
+    ///the processor owns parameters and a compiler thread that expect a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Usage: OfflineRender <command> [options] files...", true);
+
+    app.addCommand({ "--render",
+                     "--render [--state=file] [--shape=file] [--sidechain=file] [--block-size=512] [--bpm=120] "
+                     "[--threads=n] [--output-dir=dir] [--param=id:value] [--trace=file] files...",
+                     "Streams each file through the plugin and writes <name>_rendered.wav.",
+                     "Renders every file with its own processor on a thread pool. --state loads a saved plugin state, "
+                     "--shape a single shape xml on top of it, --param overrides single parameters afterwards. "
+                     "The sidechain file is looped into the aux input. The output is latency compensated "
+                     "and written as wav with the bit depth of the input. --trace writes a Chrome trace of the render "
+                     "(needs LFOTOOL_TRACE=1).",
+                     render });
+
+    app.addCommand({ "--rt-check",
+                     "--rt-check [--block-sizes=1,37,512] [--seconds=1]",
+                     "Checks that processBlock doesn't allocate, lock or make system calls.",
+                     "Renders noise through every processing path on an audio thread while the shapes are edited "
+                     "concurrently. Every allocation, mutex lock or blocking system call inside processBlock is printed "
+                     "with its stack and makes the command fail. Needs a build with LFOTOOL_REALTIME_GUARD=1 (Debug).",
+                     checkRealtime });
+
+    app.addCommand({ "--verify-determinism",
+                     "--verify-determinism [--block-sizes=1,37,64,4096] [--seconds=2] [--tolerance=0]",
+                     "Checks that the output doesn't depend on the host block size.",
+                     "Renders noise with a triggering sidechain through every processing path with the deterministic "
+                     "parameter on, once per block size, and compares each render with the first one. By default the "
+                     "renders have to be bit identical, --tolerance allows a maximum absolute difference.",
+                     verifyDeterminism });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 18 Oct 2026 9:41:12pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+juce::Optional<juce::AudioPlayHead::PositionInfo> OfflineRenderer::PlayHead::getPosition() const {
+    PositionInfo info;
+    info.setBpm(bpm);
+    info.setTimeSignature(TimeSignature{});
+    info.setIsPlaying(true);
+    info.setTimeInSamples(timeInSamples);
+    info.setTimeInSeconds(timeInSamples / sampleRate);
+    info.setPpqPosition(timeInSamples / sampleRate * bpm / 60.0);
+    return info;
+}
+
+OfflineRenderer::OfflineRenderer(const RenderSettings& settings) : settings(settings) {}
+
+std::unique_ptr<RectanglesAudioProcessor> OfflineRenderer::createProcessor(juce::String& error) const {
+    auto processor = std::make_unique<RectanglesAudioProcessor>();
+
+    if (settings.stateFile != juce::File()) {
+        juce::MemoryBlock state;
+        if (!settings.stateFile.loadFileAsData(state)) {
+            error = "Couldn't read state file " + settings.stateFile.getFullPathName();
+            return nullptr;
+        }
+        processor->setStateInformation(state.getData(), (int) state.getSize());
+    }
+
+    if (settings.shapeFile != juce::File()) {
+        auto shapeXml = juce::XmlDocument::parse(settings.shapeFile);
+        if (shapeXml == nullptr || !shapeXml->hasTagName("ShapeGraph")) {
+            error = "Couldn't read shape file " + settings.shapeFile.getFullPathName();
+            return nullptr;
+        }
+        processor->loadShapeGraphXml(*shapeXml);
+    }
+
+    ///set after the state so single parameters can be overridden on top of a preset
+    for (auto& id : settings.parameterValues.getAllKeys()) {
+        auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(processor->parameters.getParameter(id));
+        if (parameter == nullptr) {
+            error = "Unknown parameter " + id;
+            return nullptr;
+        }
+
+        const auto text = settings.parameterValues[id];
+        //numbers are in the parameter's own range, anything else goes through its text conversion ("Scrub", "Highpass")
+        const float normalised = text.containsOnly("0123456789.-") ? parameter->convertTo0to1(text.getFloatValue())
+                                                                   : parameter->getValueForText(text);
+        parameter->setValueNotifyingHost(normalised);
+    }
+
+    return processor;
+}
+
+juce::File OfflineRenderer::getOutputFile(const juce::File& input) const {
+    auto directory = settings.outputDirectory != juce::File() ? settings.outputDirectory : input.getParentDirectory();
+    return directory.getChildFile(input.getFileNameWithoutExtension() + "_rendered.wav");
+}
+
+juce::Result OfflineRenderer::render(RectanglesAudioProcessor& processor, const juce::File& input, const juce::File& output) const {
+    ///every call opens its own readers, so renders on several threads don't share a format manager
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+    if (reader == nullptr)
+        return juce::Result::fail("Couldn't read " + input.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatReader> scReader;
+    if (settings.sidechainFile != juce::File()) {
+        scReader.reset(formatManager.createReaderFor(settings.sidechainFile));
+        if (scReader == nullptr)
+            return juce::Result::fail("Couldn't read " + settings.sidechainFile.getFullPathName());
+    }
+    const bool useSidechain = scReader != nullptr && scReader->lengthInSamples > 0;
+
+    output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(output.createOutputStream());
+    if (stream == nullptr)
+        return juce::Result::fail("Couldn't write " + output.getFullPathName());
+
+    juce::WavAudioFormat wav;
+    const int bitDepth = juce::jlimit(16, 32, (int) reader->bitsPerSample);
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), reader->sampleRate,
+                                                                        (unsigned int) processor.getMainBusNumOutputChannels(), bitDepth, {}, 0));
+    if (writer == nullptr)
+        return juce::Result::fail("Couldn't create a wav writer for " + output.getFullPathName());
+    stream.release();
+
+    auto readInput = [&](juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples) {
+        reader->read(&destination, 0, numSamples, start, true, true);
+    };
+    //the sidechain loops, a block can wrap around its end
+    auto readSidechain = [&](juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples) {
+        for (int done = 0; done < numSamples;) {
+            const auto position = (start + done) % scReader->lengthInSamples;
+            const int count = (int) juce::jmin((juce::int64) (numSamples - done), scReader->lengthInSamples - position);
+            scReader->read(&destination, done, count, position, true, true);
+            done += count;
+        }
+    };
+    auto writeOutput = [&](const float* const* channels, int numChannels, int numSamples) {
+        return writer->writeFromFloatArrays(channels, numChannels, numSamples);
+    };
+
+    return renderBlocks(processor, reader->lengthInSamples, (int) reader->numChannels, useSidechain ? (int) scReader->numChannels : 0,
+                        reader->sampleRate, settings.blockSize, readInput, readSidechain, writeOutput);
+}
+
+juce::Result OfflineRenderer::renderBuffer(RectanglesAudioProcessor& processor, const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>* sidechain,
+                                           double sampleRate, int blockSize, juce::AudioBuffer<float>& output) const {
+    const bool useSidechain = sidechain != nullptr && sidechain->getNumSamples() > 0;
+    output.setSize(processor.getMainBusNumOutputChannels(), input.getNumSamples());
+    output.clear();
+
+    auto readInput = [&](juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples) {
+        for (int channel = 0; channel < destination.getNumChannels(); ++channel)
+            destination.copyFrom(channel, 0, input, channel, (int) start, numSamples);
+    };
+    auto readSidechain = [&](juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples) {
+        for (int channel = 0; channel < destination.getNumChannels(); ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                destination.setSample(channel, i, sidechain->getSample(channel, (int) ((start + i) % sidechain->getNumSamples())));
+    };
+    int written = 0;
+    auto writeOutput = [&](const float* const* channels, int numChannels, int numSamples) {
+        for (int channel = 0; channel < numChannels; ++channel)
+            output.copyFrom(channel, written, channels[channel], numSamples);
+        written += numSamples;
+        return true;
+    };
+
+    return renderBlocks(processor, input.getNumSamples(), input.getNumChannels(), useSidechain ? sidechain->getNumChannels() : 0,
+                        sampleRate, blockSize, readInput, readSidechain, writeOutput);
+}
+
+juce::Result OfflineRenderer::renderBlocks(RectanglesAudioProcessor& processor, juce::int64 length, int numInputChannels, int numSidechainChannels,
+                                           double sampleRate, int blockSize, const BlockReader& readInput, const BlockReader& readSidechain,
+                                           const BlockWriter& writeOutput) const {
+    if (blockSize <= 0)
+        return juce::Result::fail("Block size has to be positive");
+    if (numInputChannels <= 0)
+        return juce::Result::fail("The input has no channels");
+
+    PlayHead playHead(settings.bpm);
+    playHead.sampleRate = sampleRate;
+    processor.setPlayHead(&playHead);
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    ///the process buffer holds every bus, main output is channels 0/1 like in a host
+    const int numMainOutputs = processor.getMainBusNumOutputChannels();
+    const int numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::AudioBuffer<float> inputBlock(numInputChannels, blockSize);
+    juce::AudioBuffer<float> sidechainBlock(juce::jmax(1, numSidechainChannels), blockSize);
+    std::vector<const float*> outputChannels((size_t) numMainOutputs);
+    juce::MidiBuffer midi;
+    //hosts hand over a preallocated buffer, the CC output must not be the first to allocate it
+    midi.ensureSize(4096);
+
+    const auto* aux = processor.getBus(true, 1);
+    const bool feedSidechain = numSidechainChannels > 0 && aux != nullptr && aux->isEnabled();
+
+    ///render past the end by the latency and drop it from the start, so the output lines up with the input
+    const int latency = processor.getLatencySamples();
+    auto result = juce::Result::ok();
+
+    for (juce::int64 start = 0; start < length + latency; start += blockSize) {
+        const int numSamples = (int) juce::jmin((juce::int64) blockSize, length + latency - start);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+        buffer.clear();
+        midi.clear();
+
+        const int numInput = (int) juce::jlimit((juce::int64) 0, (juce::int64) numSamples, length - start);
+        if (numInput > 0) {
+            readInput(inputBlock, start, numInput);
+            for (int channel = 0; channel < processor.getMainBusNumInputChannels(); ++channel)
+                buffer.copyFrom(channel, 0, inputBlock, channel % numInputChannels, 0, numInput);
+        }
+
+        if (feedSidechain) {
+            readSidechain(sidechainBlock, start, numSamples);
+            for (int channel = 0; channel < aux->getNumberOfChannels(); ++channel)
+                buffer.copyFrom(processor.getChannelIndexInProcessBlockBuffer(true, 1, channel), 0,
+                                sidechainBlock, channel % numSidechainChannels, 0, numSamples);
+        }
+
+        playHead.timeInSamples = start;
+        processor.processBlock(buffer, midi);
+
+        ///skip the first latency samples of the output
+        const juce::int64 outputStart = start - latency;
+        const int skip = (int) juce::jmax((juce::int64) 0, -outputStart);
+        const int numOutput = (int) juce::jmin((juce::int64) (numSamples - skip), length - (outputStart + skip));
+        if (numOutput <= 0 || numMainOutputs == 0)
+            continue;
+
+        for (int channel = 0; channel < numMainOutputs; ++channel)
+            outputChannels[(size_t) channel] = buffer.getReadPointer(channel, skip);
+        if (!writeOutput(outputChannels.data(), numMainOutputs, numOutput)) {
+            result = juce::Result::fail("Couldn't write the output");
+            break;
+        }
+    }
+
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return result;
+}
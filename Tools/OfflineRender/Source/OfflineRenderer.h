@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 18 Oct 2026 9:41:12pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+
+///everything that is the same for all files of one run
+struct RenderSettings {
+    juce::File stateFile;               //plugin state as saved by getStateInformation
+    juce::File shapeFile;               //a single ShapeGraph xml, loaded into band 0
+    juce::File sidechainFile;           //streamed into the aux input, looped if shorter than the input
+    juce::File outputDirectory;         //next to the input file if not set
+    int blockSize = 512;
+    double bpm = 120.0;
+    juce::StringPairArray parameterValues;  //parameter id -> value in the parameter's own range
+};
+
+///renders audio files through RectanglesAudioProcessor without a host
+///nothing here is shared between calls, so one job per file can create its processor and render it on a thread pool
+class OfflineRenderer {
+
+private:
+
+    ///transport that plays from the start at a fixed tempo, so sync and quantize behave like in a host
+    class PlayHead : public juce::AudioPlayHead {
+    public:
+        explicit PlayHead(double bpm) : bpm(bpm) {}
+        juce::Optional<PositionInfo> getPosition() const override;
+
+        double bpm;
+        double sampleRate = 44100.0;
+        juce::int64 timeInSamples = 0;
+    };
+
+    ///fill destination with numSamples from start on, the output gets the main bus channels of each rendered block
+    using BlockReader = std::function<void(juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples)>;
+    using BlockWriter = std::function<bool(const float* const* channels, int numChannels, int numSamples)>;
+
+    RenderSettings settings;
+
+    juce::Result renderBlocks(RectanglesAudioProcessor& processor, juce::int64 length, int numInputChannels, int numSidechainChannels,
+                              double sampleRate, int blockSize, const BlockReader& readInput, const BlockReader& readSidechain,
+                              const BlockWriter& writeOutput) const;
+
+public:
+
+    explicit OfflineRenderer(const RenderSettings& settings);
+
+    //any thread, one processor per call
+    std::unique_ptr<RectanglesAudioProcessor> createProcessor(juce::String& error) const;
+    juce::File getOutputFile(const juce::File& input) const;
+
+    ///streams the file through in blocks of the block size, neither the input nor the output is held in memory
+    juce::Result render(RectanglesAudioProcessor& processor, const juce::File& input, const juce::File& output) const;
+    juce::Result renderBuffer(RectanglesAudioProcessor& processor, const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>* sidechain,
+                              double sampleRate, int blockSize, juce::AudioBuffer<float>& output) const;
+};
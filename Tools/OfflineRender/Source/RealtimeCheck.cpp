@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+    Created: 18 Oct 2026 11:58:41pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+#include "../../Common/RandomShapes.h"
+#include "../../../Source/RealtimeGuard.h"
+
+RealtimeCheck::RealtimeCheck(juce::Array<int> blockSizes, double seconds)
+    : blockSizes(std::move(blockSizes)), seconds(seconds), cases(CheckCases::getProcessingPaths()) {}
+
+juce::Result RealtimeCheck::run(std::ostream& log) const {
+    if (!RealtimeGuard::isCompiledIn())
+        return juce::Result::fail("Built without LFOTOOL_REALTIME_GUARD, use the Debug configuration");
+
+    int numViolations = 0;
+    for (auto& testCase : cases) {
+        for (int blockSize : blockSizes) {
+            const int found = runCase(testCase, blockSize, log);
+            log << testCase.name << ", block " << blockSize << ": " << (found == 0 ? "ok" : juce::String(found) + " violations") << std::endl;
+            numViolations += found;
+        }
+    }
+
+    if (numViolations > 0)
+        return juce::Result::fail(juce::String(numViolations) + " realtime violations in processBlock");
+    return juce::Result::ok();
+}
+
+int RealtimeCheck::runCase(const Case& testCase, int blockSize, std::ostream& log) const {
+    RenderSettings settings;
+    settings.parameterValues = testCase.parameterValues;
+    OfflineRenderer renderer(settings);
+
+    juce::String error;
+    auto processor = renderer.createProcessor(error);
+    if (processor == nullptr) {
+        log << error << std::endl;
+        return 1;
+    }
+
+    constexpr double sampleRate = 48000.0;
+    juce::AudioBuffer<float> input, sidechain, output;
+    juce::Random random(blockSize);
+    CheckCases::makeSignals((int) (seconds * sampleRate), random, input, sidechain);
+
+    RealtimeGuard::clearViolations();
+
+    std::atomic<bool> finished { false };
+    juce::Result result = juce::Result::ok();
+    juce::Thread::launch(juce::Thread::Priority::highest, [&] {
+        result = renderer.renderBuffer(*processor, input, &sidechain, sampleRate, blockSize, output);
+        finished = true;
+    });
+
+    ///alternate between the editor path (background compile) and state restore (synchronous compile) on all bands
+    ShapeGraph graph;
+    RandomShapes::layout(graph);
+    for (int edit = 0; !finished; ++edit) {
+        RandomShapes::fill(graph, 2 + random.nextInt(30), random);
+        const int band = edit % RectanglesAudioProcessor::maxBands;
+        if (edit % 2 == 0)
+            processor->updateLfoData(graph, band);
+        else
+            processor->loadShapeGraphXml(*graph.createXML(), band);
+        juce::Thread::sleep(2);
+    }
+
+    if (result.failed())
+        log << result.getErrorMessage() << std::endl;
+
+    const auto violations = RealtimeGuard::getViolations();
+    for (auto& violation : violations)
+        log << "  " << violation.call << " (" << violation.count << "x) in" << std::endl << violation.stack << std::endl;
+    return RealtimeGuard::getNumViolations();
+}
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+    Created: 18 Oct 2026 11:58:41pm
+    Author:  Oscar Eckhorst
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "CheckCases.h"
+
+
+///renders noise through every processing path with the realtime guard watching processBlock
+///while the audio runs on its own thread, the main thread keeps editing the shapes like the editor would,
+///so table publishing and releasing are covered as well
+class RealtimeCheck {
+
+private:
+
+    using Case = CheckCases::Case;
+
+    juce::Array<int> blockSizes;
+    double seconds;
+    std::vector<Case> cases;
+
+    int runCase(const Case& testCase, int blockSize, std::ostream& log) const;
+
+public:
+
+    RealtimeCheck(juce::Array<int> blockSizes, double seconds);
+
+    ///prints every violation with its stack, fails if there was any
+    juce::Result run(std::ostream& log) const;
+};